@@ -1,4 +1,8 @@
 <?php
+    // 载入配置文件，页面缓存命中时直接输出
+    include_once("./config.php");
+    $pagecache->page("about",$cache['page']);
+
     $title = "ImgURL - 简单、纯粹的图床程序。";
     include_once("./tpl/user/header.php");
 ?>
@@ -0,0 +1,78 @@
+<?php
+    /*
+    后台图片列表JSON接口，使用游标翻页
+    api.php?type=user|admin|dubious|sm&cursor=上一页最后一张图片ID&num=数量
+    api.php?type=trend&days=天数，返回每天的上传数量及大小
+    */
+    include_once("../functions/class/class.admin.php");
+
+    //获取类型
+    $type = $_GET['type'];
+    //获取游标，为空时返回第一页
+    $cursor = (int)$_GET['cursor'];
+    //获取数量，不超过100条
+    $num = (int)$_GET['num'];
+    if(($num <= 0) || ($num > 100)) {
+        $num = $config['pagesize'];
+    }
+
+    //趋势数据：api.php?type=trend&days=30
+    if($type == 'trend') {
+        $days = (int)$_GET['days'];
+        if(($days <= 0) || ($days > 366)) {
+            $days = 30;
+        }
+        echo json_encode(array(
+            "code"  =>  1,
+            "data"  =>  $pic->trend($days)
+        ));
+        exit;
+    }
+
+    //多查询一条用于判断是否还有下一页
+    if($type == 'sm') {
+        $datas = $pic->querysm(1,$cursor,$num + 1);
+    }
+    else{
+        $datas = $pic->querypic($type,1,$cursor,$num + 1);
+    }
+    $more = count($datas) > $num;
+    $datas = array_slice($datas,0,$num);
+
+    $list = array();
+    foreach ($datas as $img) {
+        if($type == 'sm') {
+            $list[] = array(
+                "id"    =>  $img['id'],
+                "url"   =>  $img['url'],
+                "ip"    =>  $img['ip'],
+                "date"  =>  $img['date']
+            );
+        }
+        else{
+            $list[] = array(
+                "id"        =>  $img['id'],
+                "path"      =>  $img['path'],
+                "url"       =>  $pic->url($img['path']),
+                "ip"        =>  $img['ip'],
+                "date"      =>  $img['date'],
+                "compress"  =>  $img['compress'],
+                "level"     =>  $img['level'],
+                "size"      =>  is_null($img['csize']) ? filesize(APP.$img['path']) : (int)$img['csize'],
+                "width"     =>  (int)$img['width'],
+                "height"    =>  (int)$img['height'],
+                "mime"      =>  $img['mime']
+            );
+        }
+    }
+    $last = end($datas);
+
+    //返回json数据
+    $redata = array(
+        "code"      =>  1,
+        "data"      =>  $list,
+        "cursor"    =>  $last ? $last['id'] : 0,
+        "more"      =>  $more
+    );
+    echo json_encode($redata);
+?>
@@ -0,0 +1,110 @@
+<?php
+    /*
+    后台批量操作，POST提交：type=delete|compress|cdubious|mirror|smdelete，ids=1,2,3
+    smdelete的ID为sm表的ID，其它为imginfo的ID
+    返回处理成功的ID列表
+    */
+    error_reporting(E_ALL^E_NOTICE^E_WARNING^E_DEPRECATED);
+    include_once("../functions/class/class.admin.php");
+
+    //获取操作类型
+    $type = $_POST['type'];
+    //获取图片ID，去除重复及无效的ID
+    $ids = array_values(array_unique(array_filter(array_map('intval',explode(',',$_POST['ids'])))));
+    if(empty($ids)) {
+        echo json_encode(array("code" => 0,"msg" => "请选择图片！"));
+        exit;
+    }
+    //单次最多处理500张
+    if(count($ids) > 500) {
+        echo json_encode(array("code" => 0,"msg" => "单次最多处理500张图片！"));
+        exit;
+    }
+
+    switch ($type) {
+        case 'delete':
+            $done = $pic->batchdelete($ids);
+            break;
+        case 'cdubious':
+            //取消图片可疑状态
+            $done = $pic->batchdubious($ids);
+            break;
+        case 'compress':
+            //批量压缩只写入后台任务队列，由functions/worker.php处理
+            if($tinypng['option'] != true) {
+                echo json_encode(array("code" => 0,"msg" => "未启用压缩功能！"));
+                exit;
+            }
+            if($queue['option'] != true) {
+                echo json_encode(array("code" => 0,"msg" => "批量压缩需要开启后台任务队列！"));
+                exit;
+            }
+            $dispose = new Dispose($config,$database,$tinypng,$ModerateContent,$storage);
+            $jobs = new Queue($queue,$database);
+            $datas = $database->select("imginfo",["id","path","compress","level"],[
+                "id"    =>  $ids
+            ]);
+            //之前压缩失败（如TinyPNG额度用完）的任务会重新设置为待处理，单独提示
+            $failed = array_map('intval',$database->select("queue","target",[
+                "type"      =>  "compress",
+                "target"    =>  $ids,
+                "status"    =>  3
+            ]));
+            $done = array();
+            $retry = array();
+            //所有任务在一个事务中写入
+            $database->action(function($database) use ($datas,$dispose,$jobs,$failed,&$done,&$retry) {
+                foreach ($datas as $img) {
+                    if($dispose->needcompress($img)) {
+                        $jobs->push('compress',$img['id']);
+                        $done[] = (int)$img['id'];
+                        if(in_array((int)$img['id'],$failed)) {
+                            $retry[] = (int)$img['id'];
+                        }
+                    }
+                }
+            });
+            if(!empty($retry)) {
+                echo json_encode(array(
+                    "code"  =>  1,
+                    "msg"   =>  "已处理".count($done)."张图片，其中".count($retry)."张之前压缩失败，已重新加入队列！",
+                    "ids"   =>  $done,
+                    "retry" =>  $retry
+                ));
+                exit;
+            }
+            break;
+        case 'mirror':
+            //镜像到SM.MS等远程图床，由后台任务并发上传
+            if($queue['option'] != true) {
+                echo json_encode(array("code" => 0,"msg" => "批量镜像需要开启后台任务队列！"));
+                exit;
+            }
+            $jobs = new Queue($queue,$database);
+            //已经镜像过的图片跳过；镜像已被删除的图片没有sm记录，之前已完成的任务会重新设置为待处理
+            $mirrored = $database->select("sm","imgid",[
+                "imgid" =>  $ids
+            ]);
+            $done = array_values(array_diff($database->select("imginfo","id",["id" => $ids]),$mirrored));
+            $database->action(function($database) use ($done,$jobs) {
+                foreach ($done as $id) {
+                    $jobs->push('mirror',$id);
+                }
+            });
+            $done = array_map('intval',$done);
+            break;
+        case 'smdelete':
+            //删除SM.MS图片
+            $done = $pic->batchdeletesm($ids,$queue,$mirror);
+            break;
+        default:
+            echo json_encode(array("code" => 0,"msg" => "参数错误！"));
+            exit;
+    }
+
+    echo json_encode(array(
+        "code"  =>  1,
+        "msg"   =>  "已处理".count($done)."张图片！",
+        "ids"   =>  $done
+    ));
+?>
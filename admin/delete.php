@@ -15,7 +15,7 @@
     // 判断类型
     switch ($type) {
         case 'sm':
-            $pic->deletesm($id);
+            $pic->deletesm($id,$queue,$mirror);
             break;
         
         default:
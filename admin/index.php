@@ -18,13 +18,15 @@
            <div>
            <table class="layui-table">
                 <colgroup>
-                    <col width="33%">
-                    <col width="33%">
+                    <col width="25%">
+                    <col width="25%">
+                    <col width="25%">
                     <col>
                 </colgroup>
                 <thead>
                     <tr>
                     <th>本月上传数量</th>
+                    <th>本月上传大小</th>
                     <th>今日上传</th>
                     <th>可疑图片</th>
                     </tr> 
@@ -32,6 +34,7 @@
                 <tbody>
                     <tr>
                         <td><?php echo $data['month']; ?></td>
+                        <td><?php echo round($data['bytes'] / 1048576,2); ?>MB</td>
                         <td><?php echo $data['day']; ?></td>
                         <td><?php echo $data['level']; ?></td>
                     </tr>
@@ -8,14 +8,39 @@
     $type = $_GET['type'];
     //获取页数
     $page = $_GET['page'];
-    //查询图片
-    $imgs = $pic->querypic($type,$page);
-    
-    $up = (int)$page - 1;
-    if($up <= 0){
-        $up = 1;
+    //获取游标，为上一页最后一张图片的ID
+    $cursor = (int)$_GET['cursor'];
+    //向前翻页的游标，为下一页第一张图片的ID
+    $before = (int)$_GET['before'];
+    //多查询一张判断是否还有下一页（向前翻页时为是否还有上一页）
+    $num = $config['pagesize'];
+    if($before > 0) {
+        $imgs = $pic->querypic($type,1,0,$num + 1,$before);
+        $hasprev = count($imgs) > $num;
+        $hasnext = true;
+        if($hasprev) {
+            array_shift($imgs);
+        }
+        //已经到最前面不足一页时显示第一页
+        else if(count($imgs) < $num) {
+            $before = 0;
+            $cursor = 0;
+            $page = 1;
+        }
     }
-    $down = (int)$page +1;
+    if($before == 0) {
+        $imgs = $pic->querypic($type,$page,$cursor,$num + 1);
+        $hasprev = ($cursor > 0) || ((int)$page > 1);
+        $hasnext = count($imgs) > $num;
+        if($hasnext) {
+            array_pop($imgs);
+        }
+    }
+    $first = reset($imgs);
+    $last = end($imgs);
+    //上一页：本页第一张之前的图片，本页为空时（如批量删除后）为游标所在的图片及之前的图片
+    $prev = $first ? $first['id'] : $cursor - 1;
+    $next = $last ? $last['id'] : 0;
 ?>
 
 <div class="layui-container" style = "margin-top:2em;">
@@ -28,19 +53,25 @@
          <div id = "adminpic">
          <div class="layui-col-lg9 layui-col-space10">
             <?php foreach ($imgs as $img) {
-                $imgurl = $config['domain'].$img['path'];
+                $imgurl = $pic->url($img['path']);
                 $id = $img['id'];
+                //列表显示缩略图，预览时再加载原图；v为原图修改时间，压缩后地址随之改变
+                $thumburl = ($thumb['option'] == true) ? $config['domain'].'thumb.php?path='.urlencode($img['path']).'&w=320&v='.(int)@filemtime(APP.$img['path']) : $imgurl;
             ?>
             <div class="layui-col-lg4 picadmin">
-                <a id = "imgid<?php echo $id; ?>" href="javascript:;" onclick = "adminshow('<?php echo $imgurl ?>',<?php echo $id; ?>)"><img src="<?php echo $imgurl; ?>"></a>
+                <a id = "imgid<?php echo $id; ?>" href="javascript:;" onclick = "adminshow('<?php echo $imgurl ?>',<?php echo $id; ?>)"><img src="<?php echo $thumburl; ?>"></a>
             </div>
             <?php } ?>
         </div>
         <!-- 翻页按钮 -->
         <div class="layui-col-lg9 layui-col-md-offset3">
             <div class="page">
-                <a href="?type=<?php echo $type; ?>&page=<?php echo $up; ?>" class="layui-btn">上一页</a>
-                <a href="?type=<?php echo $type; ?>&page=<?php echo $down; ?>" class="layui-btn">下一页</a>
+                <?php if($hasprev && ($prev > 0)) { ?>
+                <a href="?type=<?php echo $type; ?>&before=<?php echo $prev; ?>" class="layui-btn">上一页</a>
+                <?php } ?>
+                <?php if($hasnext) { ?>
+                <a href="?type=<?php echo $type; ?>&cursor=<?php echo $next; ?>" class="layui-btn">下一页</a>
+                <?php } ?>
             </div>
         </div>
         <!-- 翻页按钮END -->
@@ -11,11 +11,10 @@
     //查询图片
     $imgs = $pic->querypic($type,$page);
     
-    $up = (int)$page - 1;
-    if($up <= 0){
-        $up = 1;
-    }
-    $down = (int)$page +1;
+    //最后一张图片的ID，作为加载下一页的游标
+    $last = end($imgs);
+    $cursor = $last ? $last['id'] : 0;
+    $more = count($imgs) >= $config['pagesize'];
 ?>
 
 <div class="layui-container" style = "margin-top:2em;">
@@ -27,9 +26,19 @@
          <!-- 后台内容部分 -->
          <div id = "adminpic">
          <div class="layui-col-lg9">
+            <!-- 批量操作 -->
+            <div class="layui-btn-group">
+                <?php if($type == 'dubious'){ ?>
+                <a href="javascript:;" class="layui-btn layui-btn-sm layui-btn-normal" onclick = "batch('cdubious')">批量非可疑</a>
+                <?php }else{ ?>
+                <a href="javascript:;" class="layui-btn layui-btn-sm layui-btn-normal" onclick = "batch('compress')">批量压缩</a>
+                <?php } ?>
+                <a href="javascript:;" class="layui-btn layui-btn-sm layui-btn-danger" onclick = "batch('delete')">批量删除</a>
+            </div>
             <!-- 表格 -->
             <table class="layui-table">
                 <colgroup>
+                    <col width="20">
                     <col width="30">
                     <col width="280">
                     <col width="120">
@@ -39,6 +48,7 @@
                 </colgroup>
                 <thead>
                     <tr>
+                    <th><input type="checkbox" id="checkall" lay-ignore onclick = "checkall(this)"></th>
                     <th>ID</th>
                     <th>图片路径（点击可查看）</th>
                     <th>IP</th>
@@ -47,11 +57,12 @@
                     <th>操作</th>
                     </tr> 
                 </thead>
-                <tbody>
+                <tbody id="piclist">
                 <?php foreach ($imgs as $img) {
-                    $imgurl = $config['domain'].$img['path'];
+                    $imgurl = $pic->url($img['path']);
                     $id = $img['id'];
-                    $size = filesize('../'.$img['path']);     //文件大小计算
+                    //文件大小，尚未回填的旧数据才读取文件
+                    $size = is_null($img['csize']) ? filesize('../'.$img['path']) : $img['csize'];
                     $size = round($size / 1024)."kb";
                     if($img['compress'] == 0) {
                         $compress = array(
@@ -67,6 +78,7 @@
                     }
                 ?>
                    <tr id = "imgid<?php echo $id; ?>">
+                        <td><input type="checkbox" name="picid" value="<?php echo $id; ?>" lay-ignore></td>
                         <td><?php echo $id; ?></td>
                         <td><a id = "imgid<?php echo $id; ?>" href="javascript:;" onclick = "adminshow('<?php echo $imgurl ?>',<?php echo $id; ?>)"><?php echo $img['path']; ?></a></td>
                         <td><a href="javascript:;" onclick = "ipquery('<?php echo $img['ip']; ?>')"><?php echo $img['ip']; ?></a></td>
@@ -90,14 +102,13 @@
             </table>
             <!-- 表格END -->
         </div>
-        <!-- 翻页按钮 -->
+        <!-- 加载更多 -->
         <div class="layui-col-lg9 layui-col-md-offset3">
             <div class="page">
-                <a href="?type=<?php echo $type; ?>&page=<?php echo $up; ?>" class="layui-btn">上一页</a>
-                <a href="?type=<?php echo $type; ?>&page=<?php echo $down; ?>" class="layui-btn">下一页</a>
+                <a href="javascript:;" id="loadmore" class="layui-btn" data-cursor="<?php echo $cursor; ?>" onclick="loadmore('<?php echo $type; ?>','table')" <?php if(!$more){ echo 'style="display:none;"'; } ?>>加载更多</a>
             </div>
         </div>
-        <!-- 翻页按钮END -->
+        <!-- 加载更多END -->
         
         <!-- 后台内容部分END -->
     </div>
@@ -12,11 +12,10 @@
     $imgs = $pic->querysm($page);
     //var_dump($imgs);
     
-    $up = (int)$page - 1;
-    if($up <= 0){
-        $up = 1;
-    }
-    $down = (int)$page +1;
+    //最后一张图片的ID，作为加载下一页的游标
+    $last = end($imgs);
+    $cursor = $last ? $last['id'] : 0;
+    $more = count($imgs) >= $config['pagesize'];
 ?>
 
 <div class="layui-container" style = "margin-top:2em;">
@@ -30,7 +29,7 @@
          <div class="layui-col-lg9">
             <?php if($type == 'preview') { ?>
             <!-- 预览图片 -->
-            <div class="layui-col-lg9 layui-col-space10">
+            <div class="layui-col-lg9 layui-col-space10" id="piclist">
             <?php foreach ($imgs as $img) {
             ?>
             <div class="layui-col-lg4 picadmin">
@@ -58,7 +57,7 @@
                     <th>操作</th>
                     </tr> 
                 </thead>
-                <tbody>
+                <tbody id="piclist">
                 <?php foreach ($imgs as $img) {
                     
                 ?>
@@ -78,14 +77,13 @@
                 <?php } ?>
             <!-- 表格END -->
         </div>
-        <!-- 翻页按钮 -->
+        <!-- 加载更多 -->
         <div class="layui-col-lg9 layui-col-md-offset3">
             <div class="page">
-                <a href="?type=<?php echo $type; ?>&page=<?php echo $up; ?>" class="layui-btn">上一页</a>
-                <a href="?type=<?php echo $type; ?>&page=<?php echo $down; ?>" class="layui-btn">下一页</a>
+                <a href="javascript:;" id="loadmore" class="layui-btn" data-cursor="<?php echo $cursor; ?>" onclick="loadmore('sm','<?php echo ($type == 'preview') ? 'preview' : 'table'; ?>')" <?php if(!$more){ echo 'style="display:none;"'; } ?>>加载更多</a>
             </div>
         </div>
-        <!-- 翻页按钮END -->
+        <!-- 加载更多END -->
         
         <!-- 后台内容部分END -->
     </div>
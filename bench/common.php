@@ -0,0 +1,87 @@
+<?php
+    /*
+    基准测试公共文件：载入配置、切换到seed.php生成的测试数据库，并提供计时及结果输出
+    通用参数：--db=测试数据库路径 --iterations=次数 --json（输出JSON，便于不同版本之间比较）
+    */
+    error_reporting(E_ALL^E_NOTICE^E_WARNING^E_DEPRECATED);
+    if(php_sapi_name() != 'cli') {
+        echo '请在命令行下运行！';
+        exit;
+    }
+    //载入配置文件
+    include_once(__DIR__."/../config.php");
+    set_time_limit(0);
+
+    //测试数据目录
+    define("BENCH",__DIR__."/data/");
+
+    //解析 --name=value 形式的参数
+    $options = array();
+    foreach (array_slice($argv,1) as $arg) {
+        if(preg_match('/^--([a-z]+)(=(.*))?$/',$arg,$match)) {
+            $options[$match[1]] = isset($match[3]) ? $match[3] : true;
+        }
+    }
+    $benchdb = isset($options['db']) ? $options['db'] : BENCH."bench.db3";
+    if(!is_file($benchdb)) {
+        echo "测试数据库不存在，请先执行：php bench/seed.php --rows=10000\n";
+        exit(1);
+    }
+    //$database为延迟连接，第一次查询前替换数据库路径即可
+    $database->options['database_file'] = $benchdb;
+    $config['datadir'] = $benchdb;
+    //测试期间不统计性能，避免影响结果
+    $monitor['option'] = false;
+    $metrics->config['option'] = false;
+
+    $results = array();
+
+    //执行$iterations次并记录每次的耗时，先预热一次
+    function bench($name,$iterations,$callback){
+        global $results,$options;
+        if(isset($options['iterations'])) {
+            $iterations = (int)$options['iterations'];
+        }
+        $callback(0);
+        $times = array();
+        for($i = 1;$i <= $iterations;$i++) {
+            $start = hrtime(true);
+            $callback($i);
+            $times[] = (hrtime(true) - $start) / 1000000;
+        }
+        sort($times);
+        $count = count($times);
+        $result = array(
+            "name"          =>  $name,
+            "iterations"    =>  $count,
+            "mean"          =>  round(array_sum($times) / $count,4),
+            "p50"           =>  round($times[(int)floor(($count - 1) * 0.5)],4),
+            "p95"           =>  round($times[(int)floor(($count - 1) * 0.95)],4),
+            "min"           =>  round($times[0],4),
+            "max"           =>  round($times[$count - 1],4)
+        );
+        $results[] = $result;
+        if(!isset($options['json'])) {
+            printf("%-48s %8d次  平均 %10.4fms  p50 %10.4fms  p95 %10.4fms\n",$name,$count,$result['mean'],$result['p50'],$result['p95']);
+        }
+        return $result;
+    }
+
+    //输出JSON结果，包含环境信息，便于比较
+    function report(){
+        global $results,$options,$benchdb;
+        if(!isset($options['json'])) {
+            return;
+        }
+        echo json_encode(array(
+            "script"    =>  basename($_SERVER['argv'][0]),
+            "version"   =>  trim(file_get_contents(APP."functions/version.txt")),
+            "php"       =>  PHP_VERSION,
+            "opcache"   =>  function_exists('opcache_get_status') && (opcache_get_status(false) !== false),
+            "rows"      =>  (int)$GLOBALS['database']->get("bench","value",["key" => "rows"]),
+            "seed"      =>  (int)$GLOBALS['database']->get("bench","value",["key" => "seed"]),
+            "db"        =>  basename($benchdb),
+            "results"   =>  $results
+        ))."\n";
+    }
+?>
@@ -0,0 +1,33 @@
+<?php
+    /*
+    比较两次run.php的结果：php bench/compare.php old.json new.json
+    只比较两边都存在的项目，变化按平均耗时计算
+    */
+    error_reporting(E_ALL^E_NOTICE^E_WARNING^E_DEPRECATED);
+    if((php_sapi_name() != 'cli') || (count($argv) < 3)) {
+        echo "用法：php bench/compare.php old.json new.json\n";
+        exit;
+    }
+    $old = json_decode(file_get_contents($argv[1]),true);
+    $new = json_decode(file_get_contents($argv[2]),true);
+    foreach ($new as $script => $data) {
+        if(!isset($old[$script])) {
+            continue;
+        }
+        if(($old[$script]['rows'] != $data['rows']) || ($old[$script]['seed'] != $data['seed'])) {
+            echo "注意：".$script."的测试数据不同（rows/seed），结果不能直接比较\n";
+        }
+        $before = array();
+        foreach ($old[$script]['results'] as $result) {
+            $before[$result['name']] = $result;
+        }
+        foreach ($data['results'] as $result) {
+            if(!isset($before[$result['name']])) {
+                continue;
+            }
+            $a = $before[$result['name']]['mean'];
+            $b = $result['mean'];
+            printf("%-48s %10.4fms -> %10.4fms  %+7.1f%%\n",$result['name'],$a,$b,($a > 0) ? ($b - $a) * 100 / $a : 0);
+        }
+    }
+?>
@@ -0,0 +1,19 @@
+<?php
+    /*
+    探索发现抽样基准：Found::sample()，不经过页面缓存
+    php bench/found.php [--iterations=500] [--json]
+    */
+    include_once(__DIR__."/common.php");
+
+    $finder = new Found($database);
+    $thetime = substr($database->get("bench","value",["key" => "today"]),0,6);
+    $sample = array();
+    bench('Found::sample '.$config['userdir'].' '.$thetime.' '.$found['num'].'张',500,function($i) use ($finder,$config,$thetime,$found,&$sample) {
+        $sample = $finder->sample($config['userdir'],$thetime,$found['num']);
+    });
+    if(!isset($options['json'])) {
+        echo "最后一次抽取到".count($sample)."张图片\n";
+    }
+
+    report();
+?>
@@ -0,0 +1,22 @@
+// 图片后续处理压测：k6 run -e BASE=http://localhost/imgurl/ -e MAXID=10000 bench/k6/dispose.js
+// 站点需要使用seed.php生成的数据库（config.php中的datadir），ID在1-MAXID之间随机
+import http from 'k6/http';
+import { check } from 'k6';
+
+const base = __ENV.BASE || 'http://localhost/imgurl/';
+const maxid = parseInt(__ENV.MAXID || '10000');
+
+export const options = {
+    vus: parseInt(__ENV.VUS || '20'),
+    duration: __ENV.DURATION || '60s',
+    thresholds: {
+        http_req_failed: ['rate<0.01'],
+        http_req_duration: ['p(95)<300']
+    }
+};
+
+export default function () {
+    const id = 1 + Math.floor(Math.random() * maxid);
+    const res = http.get(base + 'dispose.php?id=' + id);
+    check(res, { 'code 1': (r) => r.status === 200 && r.json('code') === 1 });
+}
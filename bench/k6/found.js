@@ -0,0 +1,20 @@
+// 探索发现压测：k6 run -e BASE=http://localhost/imgurl/ bench/k6/found.js
+// $found['ttl']为0时每次请求都重新抽样，否则主要测试页面缓存
+import http from 'k6/http';
+import { check } from 'k6';
+
+const base = __ENV.BASE || 'http://localhost/imgurl/';
+
+export const options = {
+    vus: parseInt(__ENV.VUS || '50'),
+    duration: __ENV.DURATION || '60s',
+    thresholds: {
+        http_req_failed: ['rate<0.01'],
+        http_req_duration: ['p(95)<200']
+    }
+};
+
+export default function () {
+    const res = http.get(base + 'found.php');
+    check(res, { 'status 200': (r) => r.status === 200 });
+}
@@ -0,0 +1,39 @@
+// 上传压测：k6 run -e BASE=http://localhost/imgurl/ -e IMG=../data/img/1920x1080.jpg bench/k6/upload.js
+// 游客上传受$config['limit']限制，压测时请调大，或通过 -e COOKIE="user=xxx; password=xxx" 以管理员身份上传
+import http from 'k6/http';
+import { check } from 'k6';
+
+const base = __ENV.BASE || 'http://localhost/imgurl/';
+const img = open(__ENV.IMG || '../data/img/1920x1080.jpg', 'b');
+const name = (__ENV.IMG || '1920x1080.jpg').split('/').pop();
+
+export const options = {
+    scenarios: {
+        upload: {
+            executor: 'constant-arrival-rate',
+            rate: parseInt(__ENV.RATE || '20'),
+            timeUnit: '1s',
+            duration: __ENV.DURATION || '60s',
+            preAllocatedVUs: 50
+        }
+    },
+    thresholds: {
+        http_req_failed: ['rate<0.01'],
+        http_req_duration: ['p(95)<1000']
+    }
+};
+
+export default function () {
+    // 同一张图片按hash去重，参数dedup=0时每次修改末尾字节，测试完整的上传流程
+    let data = img;
+    if (__ENV.DEDUP === '0') {
+        const bytes = new Uint8Array(img.byteLength + 8);
+        bytes.set(new Uint8Array(img));
+        new DataView(bytes.buffer).setFloat64(img.byteLength, Math.random());
+        data = bytes.buffer;
+    }
+    const res = http.post(base + 'functions/upload.php', { file: http.file(data, name) }, {
+        headers: __ENV.COOKIE ? { Cookie: __ENV.COOKIE } : {}
+    });
+    check(res, { 'code 1': (r) => r.status === 200 && r.json('code') === 1 });
+}
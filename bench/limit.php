@@ -0,0 +1,30 @@
+<?php
+    /*
+    游客上传限制基准：User::limitnum()，每次使用不同的IP，--backend=sqlite|apcu|redis 指定存储方式
+    php bench/limit.php [--iterations=2000] [--backend=sqlite] [--json]
+    */
+    include_once(__DIR__."/common.php");
+    if(isset($options['backend'])) {
+        $limiter['backend'] = $options['backend'];
+    }
+    //class.user.php使用相对路径载入配置文件
+    chdir(APP."functions");
+    include_once(APP."functions/class/class.user.php");
+    //测试时不触发上传限制
+    $basis->config['limit'] = 1000000000;
+
+    $ips = 5000;
+    bench('User::limitnum '.$limiter['backend'].' '.$ips.'个IP',2000,function($i) use ($basis,$limiter,$ips) {
+        //Limiter::clientip()只使用REMOTE_ADDR
+        $_SERVER['REMOTE_ADDR'] = '10.1.'.(int)(($i % $ips) / 256).'.'.($i % 256);
+        $basis->limitnum($limiter,1);
+    });
+    //同一IP连续上传，测试行锁竞争下的开销
+    bench('User::limitnum '.$limiter['backend'].' 同一IP',2000,function($i) use ($basis,$limiter) {
+        $_SERVER['REMOTE_ADDR'] = '10.2.0.1';
+        $basis->limitnum($limiter,1);
+    });
+    unset($_SERVER['REMOTE_ADDR']);
+
+    report();
+?>
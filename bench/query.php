@@ -0,0 +1,35 @@
+<?php
+    /*
+    后台查询基准：Admin::querypic()分页及游标翻页、后台统计Admin::data()
+    php bench/query.php [--db=bench/data/bench.db3] [--iterations=200] [--json]
+    10k/1M/10M数据分别使用 php bench/seed.php --rows=10000000 --db=bench/data/bench-10m.db3 生成
+    */
+    include_once(__DIR__."/common.php");
+    //Admin在构造时校验登录状态，使用配置文件中的管理员账号
+    $_COOKIE['user'] = $config['user'];
+    $_COOKIE['password'] = md5("imgurl".$config['password']);
+    chdir(APP."admin");
+    include_once(APP."functions/class/class.admin.php");
+
+    $total = (int)$database->get("bench","value",["key" => "rows"]);
+    $pages = max(1,(int)floor($total * 0.8 / $config['pagesize']));
+    foreach (array('user','admin','dubious') as $type) {
+        bench('Admin::querypic '.$type.' 第1页',200,function($i) use ($pic,$type) {
+            $pic->querypic($type,1);
+        });
+        //深度分页，OFFSET需要跳过前面的所有记录
+        bench('Admin::querypic '.$type.' 第'.min(1000,$pages).'页',50,function($i) use ($pic,$type,$pages) {
+            $pic->querypic($type,min(1000,$pages));
+        });
+    }
+    //游标翻页，任意位置速度相同
+    $cursor = (int)($total / 2);
+    bench('Admin::querypic user 游标 id < '.$cursor,200,function($i) use ($pic,$cursor) {
+        $pic->querypic('user',1,$cursor);
+    });
+    bench('Admin::data',200,function($i) use ($pic) {
+        $pic->data();
+    });
+
+    report();
+?>
@@ -0,0 +1,39 @@
+<?php
+    /*
+    依次执行全部基准测试并保存结果
+    php bench/run.php [--db=...] [--out=bench/data/result.json]
+    不同版本的结果使用 php bench/compare.php old.json new.json 比较
+    */
+    error_reporting(E_ALL^E_NOTICE^E_WARNING^E_DEPRECATED);
+    if(php_sapi_name() != 'cli') {
+        echo '请在命令行下运行！';
+        exit;
+    }
+    set_time_limit(0);
+    $args = array();
+    $out = __DIR__."/data/result.json";
+    foreach (array_slice($argv,1) as $arg) {
+        if(strpos($arg,'--out=') === 0) {
+            $out = substr($arg,6);
+        }
+        else{
+            $args[] = escapeshellarg($arg);
+        }
+    }
+    $all = array();
+    foreach (array('upload','limit','query','found') as $name) {
+        echo "== ".$name." ==\n";
+        $json = shell_exec(escapeshellarg(PHP_BINARY).' '.escapeshellarg(__DIR__.'/'.$name.'.php').' --json '.implode(' ',$args));
+        $data = json_decode(trim((string)$json),true);
+        if(!is_array($data)) {
+            echo $json;
+            continue;
+        }
+        foreach ($data['results'] as $result) {
+            printf("%-48s 平均 %10.4fms  p95 %10.4fms\n",$result['name'],$result['mean'],$result['p95']);
+        }
+        $all[$name] = $data;
+    }
+    file_put_contents($out,json_encode($all,JSON_PRETTY_PRINT | JSON_UNESCAPED_UNICODE));
+    echo "结果已保存到".$out."\n";
+?>
@@ -0,0 +1,143 @@
+<?php
+    /*
+    生成基准测试数据，相同的参数（seed、rows、today）生成完全相同的数据，不同版本之间的结果可以直接比较
+    php bench/seed.php --rows=10000 [--seed=1] [--today=20180520] [--db=bench/data/bench.db3] [--images]
+    数据库以db/imgurl.db3为模板复制，升级过的模板才包含新增的字段及索引
+    --images 同时生成upload.php使用的测试图片（jpg/png/gif/webp，三种尺寸）
+    */
+    error_reporting(E_ALL^E_NOTICE^E_WARNING^E_DEPRECATED);
+    if(php_sapi_name() != 'cli') {
+        echo '请在命令行下运行！';
+        exit;
+    }
+    set_time_limit(0);
+    define("BENCH",__DIR__."/data/");
+
+    $options = array();
+    foreach (array_slice($argv,1) as $arg) {
+        if(preg_match('/^--([a-z]+)(=(.*))?$/',$arg,$match)) {
+            $options[$match[1]] = isset($match[3]) ? $match[3] : true;
+        }
+    }
+    $rows = isset($options['rows']) ? (int)$options['rows'] : 10000;
+    $seed = isset($options['seed']) ? (int)$options['seed'] : 1;
+    //数据的最后一天，默认为今天，保证探索发现页面本月有数据
+    $today = isset($options['today']) ? $options['today'] : date('Ymd',time());
+    $db = isset($options['db']) ? $options['db'] : BENCH."bench.db3";
+
+    if(!is_dir(dirname($db))) {
+        mkdir(dirname($db),0777,true);
+    }
+    //以项目数据库为模板，清空所有数据
+    @unlink($db);
+    @unlink($db.'-wal');
+    @unlink($db.'-shm');
+    copy(__DIR__."/../db/imgurl.db3",$db);
+    $pdo = new PDO('sqlite:'.$db);
+    $pdo->setAttribute(PDO::ATTR_ERRMODE,PDO::ERRMODE_EXCEPTION);
+    //生成数据时不需要崩溃保护
+    $pdo->exec('PRAGMA journal_mode = OFF');
+    $pdo->exec('PRAGMA synchronous = OFF');
+    foreach ($pdo->query("SELECT name FROM sqlite_master WHERE type = 'table' AND name NOT LIKE 'sqlite_%'")->fetchAll(PDO::FETCH_COLUMN) as $table) {
+        $pdo->exec('DELETE FROM "'.$table.'"');
+    }
+    $pdo->exec('DELETE FROM sqlite_sequence');
+    $pdo->exec('CREATE TABLE IF NOT EXISTS "bench" ("key" TEXT PRIMARY KEY NOT NULL,"value" TEXT)');
+
+    $columns = $pdo->query('PRAGMA table_info("imginfo")')->fetchAll(PDO::FETCH_COLUMN,1);
+    mt_srand($seed);
+
+    //数据分布在两年内，ID随日期递增，与实际上传一致
+    $end = strtotime($today);
+    $span = 730;
+    $ips = 5000;
+    $mimes = array("jpg" => "image/jpeg","png" => "image/png","gif" => "image/gif","webp" => "image/webp");
+    $exts = array("jpg","jpg","jpg","jpg","jpg","png","png","png","gif","webp");
+
+    $insert = null;
+    $pdo->beginTransaction();
+    for($i = 0;$i < $rows;$i++) {
+        $day = date('Ymd',$end - (int)floor(($rows - 1 - $i) * $span / max(1,$rows)) * 86400);
+        $hash = md5($seed.'|'.$i);
+        $ext = $exts[mt_rand(0,9)];
+        //游客上传占80%
+        $dir = (mt_rand(1,100) <= 80) ? 'temp' : 'upload';
+        //等级：0未鉴黄90%，1大众6%，2青少年2%，3成人2%
+        $r = mt_rand(1,100);
+        $level = ($r <= 90) ? 0 : (($r <= 96) ? 1 : (($r <= 98) ? 2 : 3));
+        $size = mt_rand(20000,2000000);
+        $compress = mt_rand(0,1);
+        $saved = $compress ? (int)($size * mt_rand(0,60) / 100) : 0;
+        $width = mt_rand(200,4000);
+        $phash = sprintf('%04x%04x%04x%04x',mt_rand(0,65535),mt_rand(0,65535),mt_rand(0,65535),mt_rand(0,65535));
+        $row = array(
+            "path"      =>  $dir.'/'.substr($hash,0,2).'/'.substr($hash,2,2).'/'.$hash.'.'.$ext,
+            "ip"        =>  long2ip(167772160 + mt_rand(1,$ips)),
+            "ua"        =>  "Mozilla/5.0 (bench)",
+            "date"      =>  substr($day,0,4).'-'.substr($day,4,2).'-'.substr($day,6,2),
+            "dir"       =>  $dir,
+            "compress"  =>  $compress,
+            "level"     =>  $level,
+            "hash"      =>  $hash,
+            "day"       =>  (int)$day,
+            "saved"     =>  $saved,
+            "size"      =>  $size,
+            "csize"     =>  $size - $saved,
+            "width"     =>  $width,
+            "height"    =>  (int)($width * mt_rand(50,150) / 100),
+            "mime"      =>  $mimes[$ext],
+            "phash"     =>  $phash,
+            "ph1"       =>  hexdec(substr($phash,0,4)),
+            "ph2"       =>  hexdec(substr($phash,4,4)),
+            "ph3"       =>  hexdec(substr($phash,8,4)),
+            "ph4"       =>  hexdec(substr($phash,12,4))
+        );
+        //只写入模板数据库中存在的字段
+        $row = array_intersect_key($row,array_flip($columns));
+        if(is_null($insert)) {
+            $insert = $pdo->prepare('INSERT INTO "imginfo" ("'.implode('","',array_keys($row)).'") VALUES ('.implode(',',array_fill(0,count($row),'?')).')');
+        }
+        $insert->execute(array_values($row));
+        //每5万条提交一次
+        if(($i + 1) % 50000 == 0) {
+            $pdo->commit();
+            $pdo->beginTransaction();
+            echo "已生成".($i + 1)."条\n";
+        }
+    }
+    $insert = $pdo->prepare('INSERT OR REPLACE INTO "bench" ("key","value") VALUES (?,?)');
+    foreach (array("rows" => $rows,"seed" => $seed,"today" => $today) as $key => $value) {
+        $insert->execute(array($key,$value));
+    }
+    $pdo->commit();
+    $pdo->exec('ANALYZE');
+    echo "已生成".$rows."条数据：".$db."\n";
+
+    //测试图片：按seed绘制随机色块及噪点，接近照片的压缩难度
+    if(isset($options['images'])) {
+        $imgdir = BENCH."img/";
+        if(!is_dir($imgdir)) {
+            mkdir($imgdir,0777,true);
+        }
+        foreach (array(array(640,480),array(1920,1080),array(4000,3000)) as $size) {
+            list($width,$height) = $size;
+            $image = imagecreatetruecolor($width,$height);
+            for($i = 0;$i < 200;$i++) {
+                $color = imagecolorallocate($image,mt_rand(0,255),mt_rand(0,255),mt_rand(0,255));
+                imagefilledellipse($image,mt_rand(0,$width),mt_rand(0,$height),mt_rand(20,$width / 2),mt_rand(20,$height / 2),$color);
+            }
+            for($i = 0;$i < $width * $height / 50;$i++) {
+                imagesetpixel($image,mt_rand(0,$width - 1),mt_rand(0,$height - 1),mt_rand(0,0xFFFFFF));
+            }
+            $name = $imgdir.$width.'x'.$height;
+            imagejpeg($image,$name.'.jpg',85);
+            imagepng($image,$name.'.png',6);
+            imagegif($image,$name.'.gif');
+            if(function_exists('imagewebp')) {
+                imagewebp($image,$name.'.webp',80);
+            }
+            imagedestroy($image);
+            echo "已生成测试图片：".$width.'x'.$height."\n";
+        }
+    }
+?>
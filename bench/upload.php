@@ -0,0 +1,82 @@
+<?php
+    /*
+    上传处理基准：upload::process()按格式及尺寸、文件hash算法、感知hash
+    php bench/upload.php [--iterations=10] [--json]，测试图片由 php bench/seed.php --images 生成
+    */
+    include_once(__DIR__."/common.php");
+
+    $imgdir = BENCH."img/";
+    $files = glob($imgdir."*.*");
+    if(empty($files)) {
+        echo "测试图片不存在，请先执行：php bench/seed.php --images\n";
+        exit(1);
+    }
+    natsort($files);
+    $tmpdir = BENCH."tmp/";
+    if(!is_dir($tmpdir)) {
+        mkdir($tmpdir,0777,true);
+    }
+
+    foreach ($files as $file) {
+        $name = basename($file);
+        //与Uploader相同的设置，每次处理前复制一份，避免源文件被移动
+        bench('upload::process '.$name,5,function($i) use ($file,$tmpdir,$config) {
+            $src = $tmpdir.'src_'.basename($file);
+            copy($file,$src);
+            $handle = new upload($src);
+            $handle->file_new_name_body = 'bench';
+            $handle->file_overwrite = true;
+            $handle->file_max_size = 104857600;
+            $handle->allowed = array('image/*');
+            $handle->image_max_pixels = $config['maxpixels'];
+            $handle->image_max_memory = 'auto';
+            $handle->process($tmpdir);
+            $handle->clean();
+            @unlink($handle->file_dst_pathname);
+        });
+        //缩略图：与thumb.php相同的缩放设置
+        bench('upload::process thumb640 '.$name,5,function($i) use ($file,$tmpdir) {
+            $handle = new upload($file);
+            $handle->file_new_name_body = 'thumb';
+            $handle->file_overwrite = true;
+            $handle->image_resize = true;
+            $handle->image_x = 640;
+            $handle->image_ratio_y = true;
+            $handle->image_no_enlarging = true;
+            $handle->image_max_memory = 'auto';
+            $handle->process($tmpdir);
+            @unlink($handle->file_dst_pathname);
+        });
+    }
+
+    //文件hash，按1M/10M/50M文件比较各算法
+    foreach (array(1,10,50) as $mb) {
+        $file = $tmpdir.'hash_'.$mb.'m.bin';
+        if((!is_file($file)) || (filesize($file) != $mb * 1048576)) {
+            mt_srand($mb);
+            $handle = fopen($file,'wb');
+            for($i = 0;$i < $mb * 16;$i++) {
+                fwrite($handle,str_repeat(pack('N',mt_rand()),16384));
+            }
+            fclose($handle);
+        }
+        foreach (array('md5','sha1','sha256','xxh128') as $algo) {
+            if(!in_array($algo,hash_algos())) {
+                continue;
+            }
+            bench('hash_file '.$algo.' '.$mb.'M',10,function($i) use ($algo,$file) {
+                hash_file($algo,$file);
+            });
+        }
+    }
+
+    //感知hash
+    $phash = new Phash();
+    foreach ($files as $file) {
+        bench('Phash::file '.basename($file),10,function($i) use ($phash,$file) {
+            $phash->file($file);
+        });
+    }
+
+    report();
+?>
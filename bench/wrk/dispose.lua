@@ -0,0 +1,6 @@
+-- 图片后续处理压测：MAXID=10000 wrk -t4 -c32 -d60s -s bench/wrk/dispose.lua http://localhost/imgurl/
+local maxid = tonumber(os.getenv("MAXID") or "10000")
+math.randomseed(1)
+request = function()
+    return wrk.format("GET", wrk.path .. "dispose.php?id=" .. math.random(1, maxid))
+end
@@ -0,0 +1,5 @@
+-- 探索发现压测：wrk -t4 -c64 -d60s -s bench/wrk/found.lua http://localhost/imgurl/
+wrk.method = "GET"
+request = function()
+    return wrk.format(nil, wrk.path .. "found.php")
+end
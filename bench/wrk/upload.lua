@@ -0,0 +1,22 @@
+-- 上传压测：IMG=bench/data/img/640x480.jpg wrk -t2 -c16 -d60s -s bench/wrk/upload.lua http://localhost/imgurl/
+-- 所有请求上传同一张图片，主要测试hash去重后的路径；完整上传流程请使用k6/upload.js（DEDUP=0）
+local path = os.getenv("IMG") or "bench/data/img/640x480.jpg"
+local file = io.open(path, "rb")
+local data = file:read("*all")
+file:close()
+local boundary = "----imgurlbench"
+local name = path:match("([^/]+)$")
+
+wrk.method = "POST"
+wrk.headers["Content-Type"] = "multipart/form-data; boundary=" .. boundary
+if os.getenv("COOKIE") then
+    wrk.headers["Cookie"] = os.getenv("COOKIE")
+end
+wrk.body = "--" .. boundary .. "\r\n" ..
+    "Content-Disposition: form-data; name=\"file\"; filename=\"" .. name .. "\"\r\n" ..
+    "Content-Type: application/octet-stream\r\n\r\n" ..
+    data .. "\r\n--" .. boundary .. "--\r\n"
+
+request = function()
+    return wrk.format(nil, wrk.path .. "functions/upload.php")
+end
@@ -2,37 +2,193 @@
     //项目绝对路径
     define("APP","D:/wwwroot/imgurl/");
     
-    //载入数据库类
-    include_once(APP."functions/class/Medoo.php");
-
     $config = array(
         "domain"    =>  "http://localhost/imgurl/", //站点地址
         "user"      =>  "xiaoz",                    //管理员账号
         "password"  =>  "xiaoz.me",                 //管理员密码
         "limit"		=>	5,							//游客上传数量限制
+        "batch"     =>  10,                         //单次批量上传的最大图片数量，不能超过php.ini中的max_file_uploads
+        "maxpixels" =>  50000000,                   //单张图片最大像素数，在解码前检查，避免超大尺寸图片耗尽内存
+        "hash"      =>  "auto",                     //图片hash算法：auto（PHP 8.1+使用xxh128，否则sha256）/xxh128/sha256/md5
+        "pagesize"  =>  12,                         //后台每页显示的图片数量
         "watermark"	=>	"imgurl.org",				//图片文字水印
         "userdir"   =>  "temp",                     //游客上传目录，一般不用做修改
         "admindir"  =>  "upload",                   //管理员上传目录，一般不用做修改
         "datadir"   =>  APP."db/imgurl.db3"       	//数据库路径，一般不用做修改
     );
+    //游客上传频率限制（令牌桶），每个IP最多连续上传limit张，之后按每天limit张的速度恢复
+    $limiter = array(
+        "backend"   =>  "sqlite",       //apcu/redis/sqlite，不可用时使用sqlite
+        "subnet"    =>  4,              //同一网段（IPv4 /24，IPv6 /64）共享额度为单个IP的倍数
+        "proxies"   =>  array(),        //反向代理或CDN回源的IP，如 array("127.0.0.1")，只有来自这些IP的请求才使用X-Forwarded-For
+        "redis"     =>  array(
+            "host"      =>  "127.0.0.1",
+            "port"      =>  6379,
+            "password"  =>  "",
+            "prefix"    =>  "imgurl:limit:"
+        )
+    );
+    //图片存储，local：本地磁盘；s3：兼容S3的对象存储（AWS S3、MinIO、腾讯云COS等）；oss：阿里云OSS
+    //新图片按内容hash分目录保存，如 temp/ab/cd/abcd....jpg
+    $storage = array(
+        "driver"    =>  "local",
+        "url"       =>  "",         //图片访问地址，如CDN地址 https://cdn.example.com/ ，留空使用站点地址
+        "keeplocal" =>  true,       //使用对象存储时保留本地文件，缩略图、WebP/AVIF及压缩直接读取本地文件
+        "partsize"  =>  8388608,    //超过此大小的文件使用分片上传，也是每个分片的大小（字节，不小于5M）
+        "s3"        =>  array(
+            "endpoint"  =>  "https://s3.amazonaws.com",
+            "region"    =>  "us-east-1",
+            "bucket"    =>  "",
+            "key"       =>  "",
+            "secret"    =>  "",
+            "pathstyle" =>  true    //使用 endpoint/bucket/key 形式的地址，MinIO等需要开启
+        ),
+        "oss"       =>  array(
+            "endpoint"  =>  "oss-cn-hangzhou.aliyuncs.com",
+            "bucket"    =>  "",
+            "key"       =>  "",     //AccessKey ID
+            "secret"    =>  ""      //AccessKey Secret
+        )
+    );
+    //分片上传，超过2M的图片由前端分片上传，中断后可从已上传的位置继续
+    $chunk = array(
+        "option"    =>  true,
+        "maxsize"   =>  20971520,       //分片上传时单张图片的最大大小（字节）
+        "chunksize" =>  1048576,        //每个分片的最大大小（字节）
+        "maxwidth"  =>  4096,           //宽或高超过此值的图片按比例缩小后保存，0为不缩小
+        "expire"    =>  86400,          //未完成的上传保留时间（秒）
+        "dir"       =>  "cache/chunk"   //临时文件目录
+    );
+    //缩略图，后台与探索发现页面使用thumb.php输出缩略图
+    $thumb = array(
+        "option"    =>  true,
+        "width"     =>  array(160,320,640,1280),    //允许生成的缩略图宽度
+        "quality"   =>  80,                         //缩略图JPEG质量
+        "dir"       =>  "cache/thumb",              //缩略图缓存目录
+        "maxage"    =>  2592000                     //浏览器缓存时间（秒）
+    );
+    //缩略图水印，只加在thumb.php生成的缩略图上，原图及其hash不变
+    $watermark = array(
+        "option"    =>  false,
+        "text"      =>  $config['watermark'],           //水印文字
+        "logo"      =>  "",                             //PNG格式Logo路径（相对于网站目录），填写后使用Logo代替文字
+        "font"      =>  "functions/Arial Monospaced.ttf",
+        "color"     =>  "#ffffff",
+        "opacity"   =>  60,                             //不透明度，0-100
+        "scale"     =>  0.25,                           //水印最大宽度占图片宽度的比例
+        "position"  =>  "BR",                           //水印位置，T/B/L/R组合，如BR为右下角
+        "minwidth"  =>  320,                            //小于此宽度的缩略图不加水印（如后台列表）
+        "dir"       =>  "cache/watermark"               //水印PNG缓存目录
+    );
+    //页面缓存，有APCu时使用APCu，否则使用文件缓存
+    $cache = array(
+        "backend"   =>  "auto",         //auto/file
+        "dir"       =>  "cache/data",   //文件缓存目录
+        "prefix"    =>  "imgurl:",      //APCu键名前缀，同一服务器运行多个站点时需修改
+        "page"      =>  300                 //首页、关于页面的缓存时间（秒），0为不缓存；探索发现使用$found['ttl']
+    );
+    //探索发现页面，随机结果会缓存slots份，每次访问随机返回其中一份
+    $found = array(
+        "num"       =>  12,     //每页显示的图片数量
+        "slots"     =>  8,      //缓存的随机结果份数
+        "ttl"       =>  60      //缓存时间（秒），0为不缓存；有图片上传、删除或等级变化时立即失效
+    );
     // TinyPNG压缩图片
     $tinypng = array(
         "option"    =>  false,
+        "mode"      =>  "local",                //local：上传本地文件压缩，url：由TinyPNG从站点地址下载
+        "limit"     =>  500,                    //每个key每月的免费压缩额度，按剩余额度轮换key
         "key"       =>  array(
         	"xxx",				//TinyPNG API KEY，支持填写多行key
         	"xxx"				//如果只有一个key，请删除此行
         )
     );
+    //本地图片优化，上传时直接处理，不依赖TinyPNG接口；按 vips > Imagick > GD 自动选择
+    $optimize = array(
+        "option"    =>  false,
+        "engine"    =>  "auto",     //auto/vips/imagick/gd
+        "quality"   =>  82,         //JPEG/WebP质量
+        "strip"     =>  true,       //去除EXIF等元数据
+        "webp"      =>  false,      //额外生成同名.webp文件（如abc.jpg.webp）
+        "avif"      =>  false       //额外生成同名.avif文件，需要较新版本的vips/Imagick/GD
+    );
+    //上传JPEG时的EXIF处理，直接修改文件头，不重新编码图片，也不需要exif扩展
+    //带有旋转方向的图片保留方向信息由浏览器旋转显示，缩略图、优化及压缩时按方向旋转
+    $exif = array(
+        "strip"     =>  true,       //去除EXIF/XMP等元数据（GPS位置、拍摄设备等）
+        "save"      =>  false       //将拍摄设备、拍摄时间及GPS坐标保存到数据库（make/model/taken/lat/lng字段）
+    );
     //ModerateContent 图片鉴黄，请参考帮助文档：https://doc.xiaoz.me/docs/imgurl/imgurl-jh
     $ModerateContent = array(
+        "option"        =>  false,
+        "key"           =>  "xxx",
+        "distance"      =>  3,      //感知hash汉明距离不超过此值的相似图片直接复用鉴黄结果，最大为3，0为不复用
+        "concurrency"   =>  8,      //后台任务中同时请求的数量
+        "retries"       =>  2,      //网络错误时的重试次数
+        "timeout"       =>  15      //单个请求超时时间（秒）
+    );
+
+    //后台任务队列，开启后dispose.php只写入任务，由functions/worker.php处理压缩和鉴黄
+    //crontab示例：* * * * * php /网站目录/functions/worker.php，或使用 php functions/worker.php daemon 常驻运行
+    $queue = array(
+        "option"    =>  false,
+        "batch"     =>  10,     //每次领取的任务数量
+        "lease"     =>  300,    //任务租约时间（秒），超时未完成的任务会被重新领取
+        "attempts"  =>  5,      //失败后最多重试次数
+        "sleep"     =>  3       //常驻模式下没有任务时的等待时间（秒）
+    );
+
+    //图片文件与数据库对账：php functions/reconcile.php（只输出报告）或加上--purge删除，可随时中断，下次从断点继续
+    //孤立文件只检查本地上传目录，使用S3/OSS时不会列出对象存储中的文件
+    $reconcile = array(
+        "grace"         =>  86400,                  //只处理修改时间早于此秒数的文件，避免误删正在上传或处理中的图片
+        "batch"         =>  500,                    //每批查询数据库的数量
+        "iops"          =>  200,                    //每秒最多检查的文件数量，0为不限制，生产环境请根据磁盘性能调整
+        "maxmissing"    =>  0.2,                    //--purge时一批记录中文件丢失的比例超过此值即停止删除，防止存储未挂载时误删全部记录
+        "checkpoint"    =>  "cache/reconcile.json"  //断点文件
+    );
+
+    //SM.MS及其它远程图床镜像，由后台任务队列通过curl_multi并发上传和删除
+    //镜像已有图片：php functions/mirror.php upload，清理SM.MS图片：php functions/mirror.php delete
+    $mirror = array(
+        "option"        =>  false,                          //上传到本站的图片同时镜像到远程图床，需要开启$queue
+        "api"           =>  "https://sm.ms/api/v2/upload",  //上传接口
+        "field"         =>  "smfile",                       //图片字段名
+        "token"         =>  "",                             //Authorization请求头，SM.MS的API Token，可留空
+        "url"           =>  "data.url",                     //返回JSON中图片地址的位置
+        "delete"        =>  "data.delete",                  //返回JSON中删除链接的位置
+        "concurrency"   =>  8,                              //同时进行的请求数量
+        "retries"       =>  3,                              //网络错误或服务器错误时的重试次数
+        "timeout"       =>  30                              //单个请求超时时间（秒）
+    );
+
+    //数据库连接设置
+    $dbconfig = array(
+        "type"          =>  "sqlite",   //sqlite/mysql/pgsql，多台服务器共用数据库时使用mysql或pgsql，已有数据请执行 php functions/migrate.php 迁移
+        "server"        =>  "127.0.0.1",//MySQL/PostgreSQL服务器地址，可写为 地址:端口
+        "name"          =>  "imgurl",   //数据库名
+        "username"      =>  "imgurl",
+        "password"      =>  "",
+        "charset"       =>  "utf8mb4",  //MySQL字符集，PostgreSQL使用utf8
+        "replica"       =>  array(),    //只读从库地址，如array("10.0.0.2","10.0.0.3:3306")，后台图片列表及探索发现随机选择一个读取，留空则读取主库
+        "persistent"    =>  false,      //是否使用PDO持久连接（PHP-FPM下可减少重复打开数据库）
+        //以下为SQLite设置
+        "wal"           =>  true,       //开启WAL日志模式，上传写入与页面读取可以同时进行
+        "synchronous"   =>  "NORMAL",   //WAL模式下使用NORMAL即可，FULL更安全但更慢
+        "busy_timeout"  =>  5000,       //数据库被锁定时的最长等待时间，单位毫秒
+        "mmap_size"     =>  67108864,   //内存映射读取大小，单位字节，0为关闭
+        "cache_size"    =>  -8192       //页缓存大小，负数单位为KB
+    );
+
+    //性能统计，汇总需要APCu；统计数据通过metrics.php以Prometheus格式输出
+    $monitor = array(
         "option"    =>  false,
-        "key"       =>  "xxx"
+        "header"    =>  false,              //输出Server-Timing响应头，可在浏览器开发者工具中查看各阶段耗时
+        "token"     =>  "",                 //访问metrics.php的令牌（metrics.php?token=xxx），留空时只允许本机访问
+        "prefix"    =>  "imgurl:metrics:",  //APCu key前缀
+        "buckets"   =>  array(0.01,0.025,0.05,0.1,0.25,0.5,1,2.5,5,10)     //请求耗时直方图区间（秒）
     );
 
-	//初始化Medoo
-    use Medoo\Medoo;
-    $database = new medoo([
-        'database_type' => 'sqlite',
-        'database_file' => $config['datadir']
-    ]);
+    //载入启动文件：类自动载入、数据库延迟连接
+    include_once(APP."functions/bootstrap.php");
 ?>
\ No newline at end of file
@@ -2,13 +2,6 @@
     error_reporting(E_ALL^E_NOTICE^E_WARNING^E_DEPRECATED);
     //载入配置文件
     include_once("./config.php");
-    //载入TinyPNG
-    require_once("functions/tinypng/Tinify/Exception.php");
-    require_once("functions/tinypng/Tinify/ResultMeta.php");
-    require_once("functions/tinypng/Tinify/Result.php");
-    require_once("functions/tinypng/Tinify/Source.php");
-    require_once("functions/tinypng/Tinify/Client.php");
-    require_once("functions/tinypng/Tinify.php");
 
     //初始化值
     $dispose['compress'] = 0;
@@ -17,11 +10,6 @@
     //获取ID
     $id = $_GET['id'];
     $id = (int)$id;
-    //获取tinypng key
-    $tinykey = array_rand($tinypng['key']);     //取出数组键值
-    $tinykey = $tinypng['key'][$tinykey];
-    //获取ModerateContent key
-    $mckey = $ModerateContent['key'];
 
     //如果ID不存在或为空
     if((!isset($id)) || ($id == '')) {
@@ -38,59 +26,59 @@
     ],[
         "id"    =>  $id
     ]);
-	
-    //组合为完整的URL地址
-    $imgurl = $config['domain'].$info['path'];
-    //获取压缩状态
-    $compress = $info['compress'];
-    //获取图片等级
-    $level  = $info['level'];
-    //获取文件后缀名
-    $suffix =  substr(strrchr($info['path'], '.'), 1);
-    //后缀变为小写
-    $suffix = strtolower($suffix);
-    if(($suffix == 'png') || ($suffix == 'jpg') || ($suffix == 'jpeg')) {
-        $iscompress = 1;
-    }
-    
-    //对图片进行压缩
-    if(($tinypng['option'] == true) && ($iscompress == 1) && ($compress == 0)) {
-        //初始化
-        \Tinify\setKey($tinykey);
-        $source = \Tinify\fromUrl($imgurl);
-        //覆盖原有图片
-        $source->toFile($info['path']);
-        //更新数据库
-        $database->update("imginfo",[
-            "compress"  =>  1
-        ],[
-            "id"    => $id
-        ]);
-        $dispose['compress'] = 1;
+    if(!$info) {
+        echo 'ID错误！';
+        exit;
     }
-    //对图片进行鉴黄
-    if(($ModerateContent['option'] == true) && ($level == 0)) {
-        $apiurl = "https://www.moderatecontent.com/api/v2?key=".$mckey."&url=".$imgurl;
-        $curl = curl_init($apiurl);
+    $dispose['compress'] = (int)$info['compress'];
+    $dispose['level'] = (int)$info['level'];
 
-        curl_setopt($curl, CURLOPT_USERAGENT, "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/66.0.3359.117 Safari/537.36");
-        curl_setopt($curl, CURLOPT_FAILONERROR, true);
-        curl_setopt($curl, CURLOPT_FOLLOWLOCATION, true);
-        curl_setopt($curl, CURLOPT_RETURNTRANSFER, true);
-        curl_setopt($curl, CURLOPT_SSL_VERIFYPEER, false);
-        curl_setopt($curl, CURLOPT_SSL_VERIFYHOST, false);
+    $handle = new Dispose($config,$database,$tinypng,$ModerateContent,$storage);
 
-        $html = curl_exec($curl);
-        curl_close($curl);
-
-        //更新数据库
-        $html = json_decode($html);
-        $level = $html->rating_index;
-        $database->update("imginfo",["level" =>  $level],["id"   => $id]);
-        $dispose['level'] = $level;
+    if($queue['option'] == true) {
+        //队列模式：只写入任务，由functions/worker.php在后台处理
+        //本页面不需要登录，已有任务（包括已完成及已失败的）时不再写入，失败的任务只能在后台重新执行
+        $jobs = new Queue($queue,$database);
+        if($handle->needcompress($info)) {
+            $jobs->add('compress',$id);
+        }
+        if($handle->needmoderate($info)) {
+            $jobs->add('moderate',$id);
+        }
+        //生成WebP/AVIF，用于按浏览器支持输出
+        if($optimize['option'] == true) {
+            $optimizer = new Optimizer($optimize);
+            //使用对象存储且本地文件已释放时，WebP/AVIF已在上传时处理
+            //已执行过的任务即使没有生成文件（体积没有变小或不支持AVIF）也不再写入
+            if(is_file(APP.$info['path']) && $optimizer->needvariant(APP.$info['path'])) {
+                $jobs->add('variant',$id);
+            }
+        }
+        //镜像到SM.MS等远程图床，只在第一次写入，已失败的镜像（图片被拒绝、过大等）不会重复上传
+        if($mirror['option'] == true) {
+            $jobs->add('mirror',$id);
+        }
+        //前端根据status轮询，直到压缩和鉴黄处理完成
+        $dispose['status'] = $jobs->pending($id,['compress','moderate']) ? 'pending' : 'done';
+    }
+    else{
+        //同步模式：对图片进行压缩
+        if($handle->needcompress($info)) {
+            if($handle->compress($info) !== false) {
+                $dispose['compress'] = 1;
+            }
+        }
+        //对图片进行鉴黄
+        if($handle->needmoderate($info)) {
+            $level = $handle->moderate($info);
+            if($level !== false) {
+                $dispose['level'] = $level;
+            }
+        }
+        $dispose['status'] = 'done';
     }
     //返回json数据
     $dispose['code'] = 1;
     $dispose = json_encode($dispose);
     echo $dispose;
-?>
\ No newline at end of file
+?>
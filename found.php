@@ -1,32 +1,43 @@
 <?php
+    // 载入配置文件
+    include_once("./config.php");
+    //获取当前月份(201805)
+    $thetime = date('Ym',time());
+    //随机结果缓存slots份，每次访问随机返回其中一份，命中时不连接数据库
+    $pagecache->page($thetime.':'.mt_rand(1,max(1,$found['slots'])),$found['ttl'],'found');
+
     $title = "探索发现 - ImgURL";
     include_once("./tpl/user/header.php");
-    // 载入类
-    include_once("config.php");
-    
-    //获取当前时间
-    $thetime = date('Y-m',time());
     
     //初始化
     $domain = $config['domain'];
     $userdir = $config['userdir'];
-    $sql = "SELECT `id`,`path` FROM `imginfo` WHERE (`dir` = '$userdir' AND `level` < 3 AND `date` LIKE '$thetime%') ORDER BY random() LIMIT 12";
-    $datas = $database->query($sql)->fetchAll();
-    
+    $num = $found['num'];
+
+    //随机抽取并渲染本月图片，配置了只读从库时从从库读取
+    $finder = new Found($replica);
+    $datas = $finder->sample($userdir,$thetime,$num);
+    $store = Storage::create($storage,$domain);
+    ob_start();
+    foreach ($datas as $img) {
+        $imgurl = $store->url($img['path']);
+        $imgid = $img['id'];
+        //列表显示缩略图，预览时再加载原图；v为原图修改时间，压缩后地址随之改变
+        $thumburl = ($thumb['option'] == true) ? $domain.'thumb.php?path='.urlencode($img['path']).'&w=640&v='.(int)@filemtime(APP.$img['path']) : $imgurl;
+?>
+            <div class="layui-col-lg4">
+                <a href="javascript:;" onclick = "userpreview('<?php echo $imgurl ?>',<?php echo $imgid; ?>)"><img src="<?php echo $thumburl ?>"></a>
+            </div>
+<?php
+    }
+    $html = ob_get_clean();
 ?>
 
 <div class="layui-container" style = "margin-bottom:6em;">
     <div class="layui-row">
-        <div class="msg"><i class="layui-icon">&#xe645;</i>  此页面随机显示本月12张图片，刷新页面可重新随机，如果不显示说明本月暂未上传图片。</div>
+        <div class="msg"><i class="layui-icon">&#xe645;</i>  此页面随机显示本月<?php echo $num; ?>张图片，刷新页面可重新随机，如果不显示说明本月暂未上传图片。</div>
         <div id = "found-img" class = "layui-col-space20">
-            <?php foreach ($datas as $img) {
-                    $imgurl = $domain.$img['path'];
-                    $imgid = $img['id'];
-            ?>
-            <div class="layui-col-lg4">
-                <a href="javascript:;" onclick = "userpreview('<?php echo $imgurl ?>',<?php echo $imgid; ?>)"><img src="<?php echo $imgurl ?>"></a>
-            </div>
-            <?php } ?>
+<?php echo $html; ?>
         </div>
         
     </div>  
@@ -34,4 +45,4 @@
 
 <?php
     include_once("./tpl/user/footer.php");
-?>
\ No newline at end of file
+?>
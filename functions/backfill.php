@@ -0,0 +1,92 @@
+<?php
+    /*
+    回填旧图片的大小、尺寸、MIME及感知hash，仅允许命令行运行
+    php functions/backfill.php
+    */
+    error_reporting(E_ALL^E_NOTICE^E_WARNING^E_DEPRECATED);
+    if(php_sapi_name() != 'cli') {
+        echo '请在命令行下运行！';
+        exit;
+    }
+    //载入配置文件
+    include_once(__DIR__."/../config.php");
+
+    set_time_limit(0);
+    //每批处理的数量
+    $num = 500;
+    $cursor = 0;
+    $total = 0;
+    $missing = 0;
+
+    while(true) {
+        //按ID顺序分批读取尚未回填的数据
+        $datas = $database->select("imginfo",["id","path"],[
+            "id[>]"     =>  $cursor,
+            "csize"     =>  null,
+            "ORDER"     =>  ["id" => "ASC"],
+            "LIMIT"     =>  $num
+        ]);
+        if(empty($datas)) {
+            break;
+        }
+        //每批在一个事务中更新
+        $database->action(function($database) use ($datas,&$missing) {
+            foreach ($datas as $img) {
+                $file = APP.$img['path'];
+                if(!is_file($file)) {
+                    $missing++;
+                    continue;
+                }
+                $size = filesize($file);
+                $info = @getimagesize($file);
+                $database->update("imginfo",[
+                    "size"      =>  $size,
+                    "csize"     =>  $size,
+                    "width"     =>  $info ? $info[0] : 0,
+                    "height"    =>  $info ? $info[1] : 0,
+                    "mime"      =>  $info ? $info['mime'] : null
+                ],[
+                    "id"        =>  $img['id']
+                ]);
+            }
+        });
+        $last = end($datas);
+        $cursor = $last['id'];
+        $total += count($datas);
+        echo "已处理".$total."条\n";
+    }
+    echo "回填完成，共".$total."条，其中".$missing."张图片文件不存在。\n";
+
+    //回填感知hash，用于鉴黄时复用相似图片的结果
+    $phash = new Phash();
+    $cursor = 0;
+    $total = 0;
+    while(true) {
+        $datas = $database->select("imginfo",["id","path"],[
+            "id[>]"     =>  $cursor,
+            "phash"     =>  null,
+            "ORDER"     =>  ["id" => "ASC"],
+            "LIMIT"     =>  $num
+        ]);
+        if(empty($datas)) {
+            break;
+        }
+        //先在事务外解码图片计算hash，再在一个短事务中写入，写锁不会在解码期间一直占用，不影响正常上传
+        $hashes = array();
+        foreach ($datas as $img) {
+            $ph = is_file(APP.$img['path']) ? $phash->file(APP.$img['path']) : false;
+            if($ph !== false) {
+                $hashes[$img['id']] = $ph;
+            }
+        }
+        $database->action(function($database) use ($hashes,$phash) {
+            foreach ($hashes as $id => $ph) {
+                $database->update("imginfo",["phash" => $ph] + $phash->bands($ph),["id" => $id]);
+            }
+        });
+        $last = end($datas);
+        $cursor = $last['id'];
+        $total += count($datas);
+        echo "感知hash已处理".$total."条\n";
+    }
+?>
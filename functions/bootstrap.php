@@ -0,0 +1,55 @@
+<?php
+    /*
+    公共启动文件，由config.php在末尾载入
+    注册类自动载入并创建延迟连接的$database，类文件只有在用到时才会被解析
+    */
+
+    //类自动载入
+    //Medoo\Medoo => functions/class/Medoo.php
+    //Tinify\*    => functions/tinypng/
+    //其它类      => functions/class/class.类名小写.php
+    spl_autoload_register(function($class) {
+        $name = strtolower($class);
+        if($name == 'medoo\\medoo' || $name == 'medoo\\raw') {
+            $file = APP."functions/class/Medoo.php";
+        }
+        else if(strpos($name,'tinify\\') === 0) {
+            $name = substr($class,7);
+            if(strtolower($name) == 'tinify') {
+                $file = APP."functions/tinypng/Tinify.php";
+            }
+            //所有异常类都定义在Exception.php中
+            else if(substr(strtolower($name),-9) == 'exception') {
+                $file = APP."functions/tinypng/Tinify/Exception.php";
+            }
+            else{
+                $file = APP."functions/tinypng/Tinify/".$name.".php";
+            }
+        }
+        else if(preg_match('/^[a-z0-9_]+$/',$name)) {
+            $file = APP."functions/class/class.".$name.".php";
+        }
+        else{
+            return;
+        }
+        if(is_file($file)) {
+            require_once($file);
+        }
+    });
+
+    //页面缓存，图片变化时通过$pagecache->invalidate()使探索发现页面的缓存失效
+    $pagecache = new Cache($cache);
+
+    //性能统计，未开启时各处的计时调用直接返回
+    $metrics = new Metrics($monitor);
+
+    //初始化Medoo，第一次查询时才会真正连接
+    $database = new Db(Db::options($dbconfig,$config['datadir']),$metrics);
+    //只读从库，后台图片列表及探索发现从从库读取；SQLite或未设置从库时与$database相同
+    if(($database->type() != 'sqlite') && (!empty($dbconfig['replica']))) {
+        $replica = new Db(Db::options($dbconfig,$config['datadir'],$dbconfig['replica'][array_rand($dbconfig['replica'])]),$metrics);
+    }
+    else{
+        $replica = $database;
+    }
+?>
@@ -0,0 +1,192 @@
+<?php
+    /*
+    分片上传，支持断点续传
+    POST chunk.php?action=init                      参数name、size，返回token
+    GET  chunk.php?action=status&token=              返回已上传的大小offset
+    PUT  chunk.php?action=chunk&token=&offset=       请求体为分片内容，追加到临时文件
+    POST chunk.php?action=finish&token=              上传完成，处理图片并写入数据库
+    */
+    //载入配置文件
+    include_once("./class/class.user.php");
+
+    //返回json数据并终止
+    function reply($data){
+        echo json_encode($data);
+        exit;
+    }
+    //读取上传信息，返回false表示token无效或已过期
+    function meta($token){
+        global $chunk;
+        if(!preg_match('/^[0-9a-f]{32}$/',$token)) {
+            return false;
+        }
+        $data = @file_get_contents(APP.$chunk['dir'].'/'.$token.'.json');
+        if($data === false) {
+            return false;
+        }
+        $meta = json_decode($data,true);
+        if((!is_array($meta)) || ($meta['created'] < time() - $chunk['expire'])) {
+            return false;
+        }
+        return $meta;
+    }
+    //保存上传信息
+    function savemeta($token,$meta){
+        global $chunk;
+        file_put_contents(APP.$chunk['dir'].'/'.$token.'.json',json_encode($meta),LOCK_EX);
+    }
+    //删除临时文件
+    function clear($token){
+        global $chunk;
+        foreach (glob(APP.$chunk['dir'].'/'.$token.'.*') as $file) {
+            @unlink($file);
+        }
+    }
+
+    if($chunk['option'] != true) {
+        reply(array("code" => 0,"msg" => "未启用分片上传！"));
+    }
+    $dir = APP.$chunk['dir'];
+    if(!is_dir($dir)) {
+        @mkdir($dir,0777,true);
+    }
+
+    $action = $_GET['action'];
+    $token = $_GET['token'];
+    switch ($action) {
+        case 'init':
+            $name = $_POST['name'];
+            $size = (int)$_POST['size'];
+            //只允许常见的图片扩展名，真实类型由上传类检查
+            $ext = strtolower(substr(strrchr($name,'.'),1));
+            if(!in_array($ext,array('jpg','jpeg','png','gif','bmp','webp'))) {
+                reply(array("code" => 0,"msg" => "不支持的图片格式！"));
+            }
+            if(($size <= 0) || ($size > $chunk['maxsize'])) {
+                reply(array("code" => 0,"msg" => "图片大小超过限制！"));
+            }
+            //检查用户是否登陆来判断上传目录，游客在开始上传时消耗额度
+            if($basis->check($config) == 'islogin') {
+                $updir = $config['admindir'];
+            }
+            else{
+                $updir = $config['userdir'];
+                $basis->limitnum($limiter);
+            }
+            //偶尔清理过期的临时文件
+            if(mt_rand(1,100) == 1) {
+                foreach (glob($dir.'/*.json') as $file) {
+                    if(filemtime($file) < time() - $chunk['expire']) {
+                        clear(basename($file,'.json'));
+                    }
+                }
+            }
+            //支持时保存hash的中间状态，逐个分片计算；不支持序列化HashContext时（PHP 8以下或部分算法）完成后再计算整个文件
+            $state = null;
+            $algo = Uploader::algo($config);
+            try {
+                $state = base64_encode(serialize(hash_init($algo)));
+            }
+            catch (Exception $e) {
+                $state = null;
+            }
+            $token = bin2hex(random_bytes(16));
+            touch($dir.'/'.$token.'.part');
+            savemeta($token,array(
+                "name"      =>  $name,
+                "ext"       =>  $ext,
+                "size"      =>  $size,
+                "offset"    =>  0,
+                "dir"       =>  $updir,
+                "ip"        =>  $basis->getip(),
+                "ua"        =>  $_SERVER['HTTP_USER_AGENT'],
+                "algo"      =>  $algo,
+                "state"     =>  $state,
+                "created"   =>  time()
+            ));
+            reply(array("code" => 1,"token" => $token,"offset" => 0,"chunksize" => $chunk['chunksize']));
+            break;
+        case 'status':
+            $meta = meta($token);
+            if($meta === false) {
+                reply(array("code" => 0,"msg" => "上传已失效，请重新上传！"));
+            }
+            reply(array("code" => 1,"offset" => $meta['offset'],"size" => $meta['size'],"chunksize" => $chunk['chunksize']));
+            break;
+        case 'chunk':
+            if(meta($token) === false) {
+                reply(array("code" => 0,"msg" => "上传已失效，请重新上传！"));
+            }
+            //同一个token的分片依次写入，并发请求在此等待
+            $lock = fopen($dir.'/'.$token.'.lock','c');
+            flock($lock,LOCK_EX);
+            $meta = meta($token);
+            //偏移量不一致时返回服务器上的偏移量，由前端从该位置继续
+            if((int)$_GET['offset'] != $meta['offset']) {
+                reply(array("code" => 0,"msg" => "偏移量错误！","offset" => $meta['offset']));
+            }
+            $ctx = is_null($meta['state']) ? null : unserialize(base64_decode($meta['state']));
+            //分片内容直接从请求体流式写入临时文件，不在内存中缓存整个分片
+            $input = fopen('php://input','rb');
+            $part = fopen($dir.'/'.$token.'.part','r+b');
+            ftruncate($part,$meta['offset']);
+            fseek($part,$meta['offset']);
+            $length = 0;
+            $max = min($chunk['chunksize'],$meta['size'] - $meta['offset']);
+            while(!feof($input)) {
+                $buffer = fread($input,65536);
+                if(($buffer === false) || ($buffer === '')) {
+                    break;
+                }
+                $length += strlen($buffer);
+                if($length > $max) {
+                    fclose($part);
+                    reply(array("code" => 0,"msg" => "分片大小超过限制！","offset" => $meta['offset']));
+                }
+                fwrite($part,$buffer);
+                if(!is_null($ctx)) {
+                    hash_update($ctx,$buffer);
+                }
+            }
+            fclose($part);
+            fclose($input);
+            $meta['offset'] += $length;
+            if(!is_null($ctx)) {
+                $meta['state'] = base64_encode(serialize($ctx));
+            }
+            savemeta($token,$meta);
+            reply(array("code" => 1,"offset" => $meta['offset']));
+            break;
+        case 'finish':
+            $meta = meta($token);
+            if($meta === false) {
+                reply(array("code" => 0,"msg" => "上传已失效，请重新上传！"));
+            }
+            if($meta['offset'] != $meta['size']) {
+                reply(array("code" => 0,"msg" => "图片尚未上传完成！","offset" => $meta['offset']));
+            }
+            $file = $dir.'/'.$token.'.part';
+            //上传过程中修改了hash算法时重新计算整个文件
+            $algo = Uploader::algo($config);
+            $hash = (is_null($meta['state']) || ($meta['algo'] != $algo)) ? hash_file($algo,$file) : hash_final(unserialize(base64_decode($meta['state'])));
+            //使用原扩展名，上传类根据扩展名及MIME类型检查图片
+            $src = $dir.'/'.$token.'.'.$meta['ext'];
+            rename($file,$src);
+
+            $uploader = new Uploader($config,$database,$optimize,$queue,$storage,$exif);
+            $uploader->maxsize = $chunk['maxsize'];
+            $uploader->maxwidth = $chunk['maxwidth'];
+            $result = $uploader->process($src,$meta['dir'],$meta['ip'],$meta['ua'],$hash);
+            if($result === false) {
+                clear($token);
+                reply(array("code" => 0,"msg" => $uploader->error));
+            }
+            $results = $uploader->insert(array($result));
+            clear($token);
+            reply($results[0]);
+            break;
+        default:
+            reply(array("code" => 0,"msg" => "参数错误！"));
+            break;
+    }
+?>
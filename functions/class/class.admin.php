@@ -6,9 +6,15 @@
     class Admin{
         var $config;
         var $database;
-        function __construct($config,$database) {
+        //只读从库，图片列表从从库读取，未设置时与$database相同
+        var $replica;
+        //图片存储
+        var $store;
+        function __construct($config,$database,$storage,$replica = null) {
             $this->config = $config;
             $this->database = $database;
+            $this->replica = is_null($replica) ? $database : $replica;
+            $this->store = Storage::create($storage,$config['domain']);
             $user1 = $config['user'].md5("imgurl".$config['password']);
             // echo $user1;
             //COOKIES里面的信息
@@ -25,54 +31,62 @@
             } 
         }
         //查询图片
-        function querypic($type,$page){
+        //$cursor为上一页最后一张图片的ID，传入后使用 id < cursor 翻页，无论翻到第几页查询速度都一样
+        //$before为下一页第一张图片的ID，传入后查询 id > before 最近的$num张，用于向前翻页，结果同样按ID从大到小排列
+        function querypic($type,$page,$cursor = 0,$num = 0,$before = 0){
             $config = $this->config;
-            $database = $this->database;
-
-            //分页计算
-            $start = ($page - 1) * 12;
-            //$end = $page * 12;
+            $database = $this->replica;
 
-            if(($page == '') || (!isset($page))) {
+            if(($page == '') || (!isset($page)) || ((int)$page < 1)) {
                 $page = 1;
             }
             
             //要查询的条数
-            $num = 12;
+            $num = ((int)$num > 0) ? (int)$num : $config['pagesize'];
 
             //判断类型
             switch ($type) {
                 case 'user':
-                    // echo 'dsd';
-                    $datas = $database->select("imginfo", "*", [
-                        "dir" => $config['userdir'],
-                        "ORDER" => ["id" => "DESC"],
-	                    "LIMIT" => [$start,$num]
-                    ]);
-                    // var_dump( $database->log() );
-                    // exit;
-                    return $datas;  
+                    $where = ["dir" => $config['userdir']];
                     break;
                 case 'admin':
-                    $datas = $database->select("imginfo", "*", [
-                        "dir" => $config['admindir'],
-                        "ORDER" => ["id" => "DESC"],
-                        "LIMIT" => [$start,$num]
-                    ]);
-                    return $datas;
+                    $where = ["dir" => $config['admindir']];
                     break; 
                 case 'dubious':
-                    $datas = $database->select("imginfo", "*", [
-                        "level" => 3,
-                        "ORDER" => ["id" => "DESC"],
-                        "LIMIT" => [$start,$num]
-                    ]);
-                    return $datas;
+                    $where = ["level" => 3];
                     break; 
                 default:
-                    echo 'dsddsd';
+                    return array();
                     break;
             }
+            if((int)$before > 0) {
+                $where["id[>]"] = (int)$before;
+                $where["ORDER"] = ["id" => "ASC"];
+                $where["LIMIT"] = $num;
+                return array_reverse($database->select("imginfo", "*", $where));
+            }
+            $where["ORDER"] = ["id" => "DESC"];
+            if((int)$cursor > 0) {
+                $where["id[<]"] = (int)$cursor;
+                $where["LIMIT"] = $num;
+            }
+            else{
+                //分页计算
+                $where["LIMIT"] = [((int)$page - 1) * $num,$num];
+            }
+            $datas = $database->select("imginfo", "*", $where);
+            // var_dump( $database->log() );
+            // exit;
+            return $datas;
+        }
+        //图片访问地址
+        function url($path){
+            return $this->store->url($path);
+        }
+        //图片变化后使公共页面缓存失效
+        function invalidate(){
+            global $pagecache;
+            $pagecache->invalidate();
         }
         //删除一张图片
         function delete($id){
@@ -84,16 +98,17 @@
             ]);
             
             
-            //完整的图片路径
-            $imgpath = APP.$path;
-            //如果图片删除成功，将再次删除数据库
-            
-            if(unlink($imgpath)) {
+            //如果图片删除成功，将再次删除数据库；本地文件已经不存在时同样删除记录
+            if($path && ($this->store->delete($path) || ((!$this->store->remote()) && (!is_file(APP.$path))))) {
+                //同时删除优化时生成的WebP/AVIF文件
+                $this->store->delete($path.'.webp');
+                $this->store->delete($path.'.avif');
                 $del = $database->delete("imginfo", [
                     "AND" => [
                         "id" => $id
                     ]
                 ]);
+                $this->invalidate();
                 echo 'ok';
             }
             else{
@@ -101,35 +116,89 @@
             }
             
         }
-        //统计数据
+        //批量删除图片，先逐个删除文件，再在一个事务中删除数据库记录，返回已删除的ID
+        function batchdelete($ids){
+            $datas = $this->database->select("imginfo",["id","path"],[
+                "id"    =>  $ids
+            ]);
+            $done = array();
+            foreach ($datas as $img) {
+                //本地文件已经不存在的图片同样清理数据库记录
+                if($this->store->delete($img['path']) || ((!$this->store->remote()) && (!is_file(APP.$img['path'])))) {
+                    $this->store->delete($img['path'].'.webp');
+                    $this->store->delete($img['path'].'.avif');
+                    $done[] = (int)$img['id'];
+                }
+            }
+            if(!empty($done)) {
+                $this->database->action(function($database) use ($done) {
+                    //分批删除，避免超过SQLite的参数数量限制
+                    foreach (array_chunk($done,500) as $chunk) {
+                        $database->delete("imginfo",["id" => $chunk]);
+                    }
+                });
+                $this->invalidate();
+            }
+            return $done;
+        }
+        //批量取消图片可疑状态，返回处理的ID
+        function batchdubious($ids){
+            $datas = $this->database->select("imginfo","id",[
+                "id"    =>  $ids,
+                "level" =>  3
+            ]);
+            if(!empty($datas)) {
+                $this->database->update("imginfo",[
+                    "level"     =>  1
+                ],[
+                    "id"        =>  $datas
+                ]);
+                $this->invalidate();
+            }
+            return array_map('intval',$datas);
+        }
+        //统计数据，读取由触发器维护的stats表，不再统计imginfo
         function data() {
-            //获取当前月份
-            $themonth = date('Y-m',time());
-            //获取当天时间
-            $theday = date('Y-m-d',time());
+            //获取当前月份(201805)
+            $themonth = date('Ym',time());
+            //获取当天时间(20180506)
+            $theday = (int)date('Ymd',time());
+            $range = [(int)($themonth.'00'),(int)($themonth.'31')];
             
-            //统计本月上传图片数量
-            $month = $this->database->count("imginfo",[
-                "date[~]"  =>  $themonth
+            //统计本月上传图片数量及大小
+            $month = $this->database->sum("stats","num",[
+                "day[<>]"  =>  $range
+            ]);
+            $bytes = $this->database->sum("stats","bytes",[
+                "day[<>]"  =>  $range
             ]);
             
-            $day = $this->database->count("imginfo",[
-                "date"  =>  $theday
+            $day = $this->database->sum("stats","num",[
+                "day"  =>  $theday
             ]);
             
             //统计可疑图片
-            $level = $this->database->count("imginfo",[
+            $level = $this->database->sum("stats","num",[
                 "level"  =>  3
             ]);
             
             //返回数据
             $redata = array(
-                "month" =>  $month,
-                "day"   =>  $day,
-                "level" =>  $level
+                "month" =>  (int)$month,
+                "day"   =>  (int)$day,
+                "level" =>  (int)$level,
+                "bytes" =>  (int)$bytes
             );
             return $redata;
         }
+        //最近若干天每天的上传数量及大小，用于趋势图
+        function trend($days = 30) {
+            $start = (int)date('Ymd',time() - ((int)$days - 1) * 86400);
+            $datas = $this->database->query('SELECT "day",SUM("num") AS "num",SUM("bytes") AS "bytes" FROM "stats" WHERE "day" >= :start GROUP BY "day" ORDER BY "day" ASC',[
+                ":start"    =>  $start
+            ])->fetchAll(PDO::FETCH_ASSOC);
+            return $datas;
+        }
         //取消图片可疑状态
         function cdubious($id){
             $database = $this->database;
@@ -138,6 +207,7 @@
             ],[
                 "id"        =>  $id
             ]);
+            $this->invalidate();
             echo 'ok';
         }
         //对某张图片进行压缩，未开发完成
@@ -155,60 +225,68 @@
                 
             }
         }
-        //查询SM.MS图片
-        //查询图片
-        function querysm($page){
+        //查询SM.MS图片，$cursor用法同querypic
+        function querysm($page,$cursor = 0,$num = 0){
             $config = $this->config;
-            $database = $this->database;
-
-            //分页计算
-            $start = ($page - 1) * 12;
-            //$end = $page * 12;
+            $database = $this->replica;
 
-            if(($page == '') || (!isset($page))) {
+            if(($page == '') || (!isset($page)) || ((int)$page < 1)) {
                 $page = 1;
             }
             
             //要查询的条数
-            $num = 12;
+            $num = ((int)$num > 0) ? (int)$num : $config['pagesize'];
 
-            //判断类型
-            $datas = $database->select("sm", "*", [
-                "ORDER" => ["id" => "DESC"],
-                "LIMIT" => [$start,$num]
-            ]);
+            $where = ["ORDER" => ["id" => "DESC"]];
+            if((int)$cursor > 0) {
+                $where["id[<]"] = (int)$cursor;
+                $where["LIMIT"] = $num;
+            }
+            else{
+                //分页计算
+                $where["LIMIT"] = [((int)$page - 1) * $num,$num];
+            }
+            $datas = $database->select("sm", "*", $where);
             return $datas;
         }
-        //删除SM.MS图片
-        function deletesm($id){
-            $config = $this->config;
-            $database = $this->database;
-            //先查询数据库
-            $query = $database->get("sm","*",[
-                "id"    =>  $id
-            ]);
-            $delete = $database->delete("sm", [
-                "AND" => [
-                    "id" => $id
-                ]
-            ]);
-            //请求接口删除图片
-            $curl = curl_init($query['delete']);
-
-            curl_setopt($curl, CURLOPT_USERAGENT, "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/66.0.3359.139 Safari/537.36");
-            curl_setopt($curl, CURLOPT_FAILONERROR, true);
-            curl_setopt($curl, CURLOPT_FOLLOWLOCATION, true);
-            curl_setopt($curl, CURLOPT_RETURNTRANSFER, true);
-            curl_setopt($curl, CURLOPT_SSL_VERIFYPEER, false);
-            curl_setopt($curl, CURLOPT_SSL_VERIFYHOST, false);
-            #设置超时时间，最小为1s（可选）
-            curl_setopt($curl , CURLOPT_TIMEOUT, 2);
-
-            $html = curl_exec($curl);
-            curl_close($curl);
+        //删除SM.MS图片，开启队列时由后台任务请求删除链接
+        function deletesm($id,$queue,$mirror){
+            $this->batchdeletesm(array($id),$queue,$mirror);
             echo 'ok';
         }
+        //批量删除SM.MS图片，先在一个事务中删除记录，再并发请求删除链接，返回已删除的ID
+        function batchdeletesm($ids,$queue,$mirror){
+            $datas = $this->database->select("sm",["id","delete"],[
+                "id"    =>  $ids
+            ]);
+            if(empty($datas)) {
+                return array();
+            }
+            $done = array();
+            $links = array();
+            foreach ($datas as $sm) {
+                $done[] = (int)$sm['id'];
+                $links[$sm['id']] = $sm['delete'];
+            }
+            $this->database->action(function($database) use ($done,$links,$queue) {
+                foreach (array_chunk($done,500) as $chunk) {
+                    $database->delete("sm",["id" => $chunk]);
+                }
+                if($queue['option'] == true) {
+                    $jobs = new Queue($queue,$database);
+                    foreach ($links as $id => $link) {
+                        $jobs->push('smdelete',$id,array("delete" => $link));
+                    }
+                }
+            });
+            //未开启队列时直接并发请求，删除链接失败不影响记录删除
+            if($queue['option'] != true) {
+                $sm = new Sm($mirror,$this->database);
+                $sm->delete($links);
+            }
+            return $done;
+        }
     }
 
-    $pic = new Admin($config,$database);
+    $pic = new Admin($config,$database,$storage,$replica);
 ?>
\ No newline at end of file
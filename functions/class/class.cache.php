@@ -0,0 +1,133 @@
+<?php
+    /*
+    缓存类，有APCu时使用APCu，否则使用文件缓存
+    */
+    class Cache{
+        var $config;
+        //实际使用的存储方式：apcu/file
+        var $backend;
+
+        //构造函数，$config为配置文件中的$cache
+        public function __construct($config){
+            $this->config = $config;
+            if(($config['backend'] != 'file') && function_exists('apcu_fetch') && ini_get('apc.enabled')) {
+                $this->backend = 'apcu';
+            }
+            else{
+                $this->backend = 'file';
+            }
+        }
+        //缓存文件路径
+        function path($key){
+            $key = md5($key);
+            return APP.$this->config['dir'].'/'.substr($key,0,2).'/'.$key.'.cache';
+        }
+        //读取缓存，不存在或已过期返回false
+        function get($key){
+            if($this->backend == 'apcu') {
+                return apcu_fetch($this->config['prefix'].$key);
+            }
+            $file = $this->path($key);
+            $data = @file_get_contents($file);
+            if($data === false) {
+                return false;
+            }
+            $data = unserialize($data);
+            //过期时间为0表示永不过期
+            if((!is_array($data)) || (($data[0] != 0) && ($data[0] < time()))) {
+                return false;
+            }
+            return $data[1];
+        }
+        //写入缓存，$ttl为有效时间（秒），0为永不过期
+        function set($key,$value,$ttl = 0){
+            if($this->backend == 'apcu') {
+                return apcu_store($this->config['prefix'].$key,$value,$ttl);
+            }
+            $file = $this->path($key);
+            if(!is_dir(dirname($file))) {
+                @mkdir(dirname($file),0777,true);
+            }
+            //先写临时文件再更名，避免读取到写了一半的缓存
+            $tmpfile = $file.'.'.uniqid().'.tmp';
+            $expire = ($ttl > 0) ? time() + $ttl : 0;
+            if(file_put_contents($tmpfile,serialize(array($expire,$value))) === false) {
+                return false;
+            }
+            //偶尔清理一个子目录中过期的缓存文件
+            if(mt_rand(1,100) == 1) {
+                $this->gc(sprintf('%02x',mt_rand(0,255)));
+            }
+            return rename($tmpfile,$file);
+        }
+        //文件缓存：删除子目录$sub中已过期的缓存及写入中断留下的临时文件，APCu自动清理
+        function gc($sub){
+            $now = time();
+            $files = @glob(APP.$this->config['dir'].'/'.$sub.'/*');
+            if(!is_array($files)) {
+                return;
+            }
+            foreach ($files as $file) {
+                if(substr($file,-4) == '.tmp') {
+                    if(@filemtime($file) < $now - 3600) {
+                        @unlink($file);
+                    }
+                    continue;
+                }
+                //文件开头为 a:2:{i:0;i:过期时间;
+                $fp = @fopen($file,'rb');
+                if(!$fp) {
+                    continue;
+                }
+                $head = fread($fp,32);
+                fclose($fp);
+                if(preg_match('/^a:2:\{i:0;i:(\d+);/',$head,$match) && ($match[1] != 0) && ($match[1] < $now)) {
+                    @unlink($file);
+                }
+            }
+        }
+        //删除缓存
+        function delete($key){
+            if($this->backend == 'apcu') {
+                return apcu_delete($this->config['prefix'].$key);
+            }
+            return @unlink($this->path($key));
+        }
+        //页面缓存分组的版本号，不存在时为0
+        function version($group){
+            $version = $this->get('page:version:'.$group);
+            return ($version === false) ? 0 : $version;
+        }
+        //图片上传、删除或等级变化后调用，更换版本号使该分组的页面缓存失效，默认为探索发现页面；首页、关于与图片无关，只按缓存时间过期
+        function invalidate($group = 'found'){
+            return $this->set('page:version:'.$group,uniqid('',true));
+        }
+        /*
+        页面输出缓存，在页面载入模板之前调用
+        命中时直接输出并结束，未命中时缓冲页面输出，执行完成后写入缓存；$group为使用invalidate()失效的分组
+        只缓存未登录访客看到的页面，带有user cookie的请求（已登录或伪造的cookie）顶部会显示用户名及后台菜单，不读取也不写入缓存
+        */
+        function page($name,$ttl,$group = ''){
+            if(($ttl <= 0) || ($_SERVER['REQUEST_METHOD'] != 'GET') || isset($_COOKIE['user'])) {
+                return;
+            }
+            //$group不为空时缓存随该分组的版本号失效
+            $key = 'page:'.(($group != '') ? $group.':'.$this->version($group).':' : '').$name;
+            $html = $this->get($key);
+            if($html !== false) {
+                header('Content-Type: text/html; charset=utf-8');
+                echo $html;
+                exit;
+            }
+            ob_start();
+            $cache = $this;
+            register_shutdown_function(function() use ($cache,$key,$ttl) {
+                //页面出错时不缓存
+                $error = error_get_last();
+                if((http_response_code() == 200) && ((!$error) || (!in_array($error['type'],array(E_ERROR,E_PARSE,E_CORE_ERROR,E_COMPILE_ERROR))))) {
+                    $cache->set($key,ob_get_contents(),$ttl);
+                }
+            });
+        }
+    }
+?>
@@ -0,0 +1,88 @@
+<?php
+    /*
+    数据库延迟连接，第一次调用Medoo方法时才载入Medoo并打开数据库
+    缓存命中或被拒绝的请求不会连接数据库
+    */
+    class Db{
+        //Medoo初始化参数
+        var $options;
+        var $medoo;
+        //性能统计，开启时使用带计时的Timedmedoo
+        var $metrics;
+
+        public function __construct($options,$metrics = null){
+            $this->options = $options;
+            $this->metrics = $metrics;
+        }
+        /*
+        根据配置文件中的$dbconfig生成Medoo初始化参数
+        $server为连接的服务器（地址:端口），用于只读从库，默认连接主库
+        */
+        static function options($dbconfig,$file,$server = null){
+            $type = in_array($dbconfig['type'],array('mysql','pgsql')) ? $dbconfig['type'] : 'sqlite';
+            if($type == 'sqlite') {
+                //每次连接后执行的PRAGMA
+                $command = array();
+                if($dbconfig['wal'] == true) {
+                    $command[] = "PRAGMA journal_mode = WAL";
+                }
+                $command[] = "PRAGMA synchronous = ".$dbconfig['synchronous'];
+                $command[] = "PRAGMA busy_timeout = ".(int)$dbconfig['busy_timeout'];
+                $command[] = "PRAGMA mmap_size = ".(int)$dbconfig['mmap_size'];
+                $command[] = "PRAGMA cache_size = ".(int)$dbconfig['cache_size'];
+                return [
+                    'database_type' => 'sqlite',
+                    'database_file' => $file,
+                    'option'        => [
+                        PDO::ATTR_PERSISTENT    =>  (bool)$dbconfig['persistent'],
+                        PDO::ATTR_TIMEOUT       =>  (int)ceil($dbconfig['busy_timeout'] / 1000),
+                        //PHP 8默认出错时抛出异常，统一为返回错误码，与PHP 7一致
+                        PDO::ATTR_ERRMODE       =>  PDO::ERRMODE_SILENT
+                    ],
+                    'command'       => $command
+                ];
+            }
+            $server = explode(':',is_null($server) ? $dbconfig['server'] : $server,2);
+            $options = [
+                'database_type' => $type,
+                'server'        => $server[0],
+                'database_name' => $dbconfig['name'],
+                'username'      => $dbconfig['username'],
+                'password'      => $dbconfig['password'],
+                'charset'       => ($type == 'mysql') ? $dbconfig['charset'] : 'utf8',
+                'option'        => [
+                    PDO::ATTR_PERSISTENT    =>  (bool)$dbconfig['persistent'],
+                    PDO::ATTR_ERRMODE       =>  PDO::ERRMODE_SILENT
+                ]
+            ];
+            if(isset($server[1])) {
+                $options['port'] = (int)$server[1];
+            }
+            return $options;
+        }
+        //数据库类型：sqlite/mysql/pgsql
+        function type(){
+            return $this->options['database_type'];
+        }
+        //返回Medoo对象，不存在时创建
+        function connect(){
+            if(!$this->medoo) {
+                if((!is_null($this->metrics)) && $this->metrics->enabled()) {
+                    $this->medoo = new Timedmedoo($this->options);
+                    $this->medoo->metrics = $this->metrics;
+                }
+                else{
+                    $this->medoo = new Medoo\Medoo($this->options);
+                }
+            }
+            return $this->medoo;
+        }
+        //其它方法全部转发给Medoo
+        function __call($name,$args){
+            return call_user_func_array(array($this->connect(),$name),$args);
+        }
+        function __get($name){
+            return $this->connect()->$name;
+        }
+    }
+?>
@@ -0,0 +1,277 @@
+<?php
+    /*
+    图片后续处理类：TinyPNG压缩与ModerateContent鉴黄
+    dispose.php（同步模式）与functions/worker.php（队列模式）共用
+    */
+    class Dispose{
+        var $config;
+        var $database;
+        var $tinypng;
+        var $moderate;
+        //图片存储
+        var $store;
+        //最近一次处理失败的原因
+        var $error;
+        //批量鉴黄时每张图片失败的原因
+        var $errors = array();
+
+        //构造函数
+        public function __construct($config,$database,$tinypng,$moderate,$storage){
+            $this->config = $config;
+            $this->database = $database;
+            $this->tinypng = $tinypng;
+            $this->moderate = $moderate;
+            $this->store = Storage::create($storage,$config['domain']);
+        }
+        //判断图片后缀是否支持压缩
+        function iscompress($path){
+            //获取文件后缀名并转为小写
+            $suffix = strtolower(substr(strrchr($path, '.'), 1));
+            if(($suffix == 'png') || ($suffix == 'jpg') || ($suffix == 'jpeg')) {
+                return true;
+            }
+            return false;
+        }
+        //是否需要压缩
+        function needcompress($info){
+            return ($this->tinypng['option'] == true) && ($info['compress'] == 0) && $this->iscompress($info['path']);
+        }
+        //是否需要鉴黄
+        function needmoderate($info){
+            return ($this->moderate['option'] == true) && ($info['level'] == 0);
+        }
+        //选择本月剩余额度最多的TinyPNG key，额度全部用完时返回false
+        function tinykey(){
+            $month = (int)date('Ym',time());
+            $limit = $this->tinypng['limit'];
+            $keys = $this->database->select("tinykey",["key","count"],[
+                "month" =>  $month
+            ]);
+            $used = array();
+            foreach ($keys as $value) {
+                $used[$value['key']] = $value['count'];
+            }
+            $tinykey = false;
+            $min = $limit;
+            foreach ($this->tinypng['key'] as $key) {
+                $count = isset($used[$key]) ? $used[$key] : 0;
+                if($count < $min) {
+                    $tinykey = $key;
+                    $min = $count;
+                }
+            }
+            return $tinykey;
+        }
+        //记录TinyPNG key本月已使用次数
+        function tinycount($key,$count){
+            $month = (int)date('Ym',time());
+            $where = ["key" =>  $key];
+            if($this->database->has("tinykey",$where)) {
+                $this->database->update("tinykey",[
+                    "month" =>  $month,
+                    "count" =>  $count
+                ],$where);
+            }
+            else{
+                $this->database->insert("tinykey",[
+                    "key"   =>  $key,
+                    "month" =>  $month,
+                    "count" =>  $count
+                ]);
+            }
+        }
+        //压缩图片，成功返回1，失败返回false
+        function compress($info){
+            //按需载入TinyPNG，Tinify.php中的函数无法自动载入，这里先载入Tinify类所在文件
+            class_exists('Tinify\\Tinify');
+
+            //获取tinypng key
+            $tinykey = $this->tinykey();
+            if($tinykey === false) {
+                $this->error = 'TinyPNG本月压缩额度已用完！';
+                return false;
+            }
+            //本地图片路径，对象存储且不保留本地文件时先下载
+            $imgpath = $this->store->fetch($info['path']);
+            $size = ($imgpath === false) ? false : filesize($imgpath);
+            if($size === false) {
+                $this->error = '图片不存在！';
+                return false;
+            }
+
+            //TinyPNG不保留EXIF，带有旋转方向的图片压缩后写回方向
+            $exif = new Exif();
+            $orientation = $exif->orientation($imgpath);
+
+            global $metrics;
+            $start = $metrics->now();
+            try {
+                \Tinify\setKey($tinykey);
+                if($this->tinypng['mode'] == 'url') {
+                    //由TinyPNG从站点地址下载图片
+                    $source = \Tinify\fromUrl($this->store->url($info['path']));
+                }
+                else{
+                    //直接上传本地文件，不再经过站点回源
+                    $source = \Tinify\fromFile($imgpath);
+                }
+                $data = $source->toBuffer();
+                $this->tinycount($tinykey,\Tinify\compressionCount());
+            }
+            catch (Exception $e) {
+                $metrics->stop('http',$start,0,array("host" => "api.tinify.com"));
+                $this->error = $e->getMessage();
+                return false;
+            }
+            $metrics->stop('http',$start,(($this->tinypng['mode'] == 'url') ? 0 : $size) + strlen($data),array("host" => "api.tinify.com"));
+
+            //压缩后更小才覆盖原图，先写临时文件再更名，避免读取到写了一半的图片
+            $saved = $size - strlen($data);
+            $csize = $size;
+            if($saved > 0) {
+                $csize = strlen($data);
+                $tmpfile = $imgpath.'.'.uniqid().'.tmp';
+                $written = (file_put_contents($tmpfile,$data) !== false);
+                if($written && ($orientation > 1)) {
+                    $exif->strip($tmpfile,$orientation);
+                    clearstatcache();
+                    $csize = filesize($tmpfile);
+                    $saved = $size - $csize;
+                }
+                if((!$written) || (!rename($tmpfile,$imgpath))) {
+                    @unlink($tmpfile);
+                    $this->error = '写入压缩图片失败！';
+                    return false;
+                }
+                //使用对象存储时上传压缩后的图片
+                if(!$this->store->put($imgpath,$info['path'])) {
+                    $this->error = $this->store->error;
+                    return false;
+                }
+            }
+            else{
+                $saved = 0;
+            }
+            $this->store->release($info['path']);
+            //更新数据库
+            $this->database->update("imginfo",[
+                "compress"  =>  1,
+                "saved"     =>  $saved,
+                "csize"     =>  $csize
+            ],[
+                "id"    =>  $info['id']
+            ]);
+            return 1;
+        }
+        //图片鉴黄，成功返回图片等级，失败返回false
+        function moderate($info){
+            $levels = $this->moderatebatch(array($info));
+            if($levels[0] === false) {
+                $this->error = $this->errors[0];
+            }
+            return $levels[0];
+        }
+        //查找已经鉴黄且感知hash相近的图片，返回其中最高的等级，没有时返回false
+        function similar($info,$distance){
+            if(($info['phash'] == '') || ($distance <= 0)) {
+                return false;
+            }
+            $phash = new Phash();
+            $datas = $this->database->select("imginfo",["phash","level"],[
+                "OR"        =>  $phash->bands($info['phash']),
+                "level[>]"  =>  0,
+                "id[!]"     =>  $info['id'],
+                "LIMIT"     =>  100
+            ]);
+            $level = false;
+            foreach ($datas as $img) {
+                if(($phash->distance($info['phash'],$img['phash']) <= $distance) && ($img['level'] > $level)) {
+                    $level = (int)$img['level'];
+                }
+            }
+            return $level;
+        }
+        /*
+        批量鉴黄，$infos为 key => 图片信息，返回 key => 等级 或false（原因在$this->errors中）
+        相似图片已有结果时直接复用，同一批次中相似的图片只请求一次，其余的通过连接池并发请求
+        */
+        function moderatebatch($infos){
+            $this->errors = array();
+            $levels = array();
+            if(empty($infos)) {
+                return $levels;
+            }
+            $phash = new Phash();
+            $distance = min((int)$this->moderate['distance'],$phash->maxdistance);
+            $ids = array();
+            foreach ($infos as $info) {
+                $ids[] = $info['id'];
+            }
+            $phashes = array();
+            foreach ($this->database->select("imginfo",["id","phash"],["id" => $ids]) as $img) {
+                $phashes[$img['id']] = $img['phash'];
+            }
+
+            $requests = array();
+            //已发送请求的图片的感知hash，以及与其相似、等待复用结果的图片
+            $sent = array();
+            $follow = array();
+            foreach ($infos as $key => $info) {
+                $info['phash'] = isset($phashes[$info['id']]) ? $phashes[$info['id']] : '';
+                $level = $this->similar($info,$distance);
+                if($level !== false) {
+                    $levels[$key] = $level;
+                    continue;
+                }
+                if($info['phash'] != '') {
+                    foreach ($sent as $k => $ph) {
+                        if($phash->distance($info['phash'],$ph) <= $distance) {
+                            $follow[$key] = $k;
+                            continue 2;
+                        }
+                    }
+                    $sent[$key] = $info['phash'];
+                }
+                //组合为完整的URL地址
+                $imgurl = $this->store->url($info['path']);
+                $requests[$key] = array(
+                    CURLOPT_URL             =>  "https://www.moderatecontent.com/api/v2?key=".$this->moderate['key']."&url=".urlencode($imgurl),
+                    CURLOPT_SSL_VERIFYPEER  =>  false,
+                    CURLOPT_SSL_VERIFYHOST  =>  false
+                );
+            }
+
+            $pool = new Pool($this->moderate);
+            foreach ($pool->run($requests) as $key => $result) {
+                $data = json_decode($result['body']);
+                if(($result['error'] != '') || (!isset($data->rating_index)) || (!is_numeric($data->rating_index))) {
+                    $levels[$key] = false;
+                    $this->errors[$key] = ($result['error'] != '') ? $result['error'] : (isset($data->error) ? $data->error : '鉴黄接口返回数据错误！');
+                    continue;
+                }
+                $levels[$key] = (int)$data->rating_index;
+            }
+            foreach ($follow as $key => $k) {
+                $levels[$key] = $levels[$k];
+                if($levels[$k] === false) {
+                    $this->errors[$key] = $this->errors[$k];
+                }
+            }
+
+            //更新数据库
+            $this->database->action(function($database) use ($infos,$levels) {
+                foreach ($levels as $key => $level) {
+                    if($level !== false) {
+                        $database->update("imginfo",["level" => $level],["id" => $infos[$key]['id']]);
+                    }
+                }
+            });
+            //可疑图片不在探索发现中显示
+            if(in_array(3,$levels,true)) {
+                global $pagecache;
+                $pagecache->invalidate();
+            }
+            return $levels;
+        }
+    }
+?>
@@ -0,0 +1,306 @@
+<?php
+    /*
+    JPEG元数据处理，直接解析文件头中的APP段，不需要exif扩展，也不解码图片
+    read()一次读取方向、拍摄设备、拍摄时间及GPS坐标；strip()整段删除EXIF/XMP等元数据及EOI之后附加的图片，压缩数据原样复制
+    带有旋转方向的图片只保留一个最小的EXIF段记录方向，由浏览器旋转显示，避免重新编码损失画质
+    */
+    class Exif{
+        //保留的APP段：APP0（JFIF）、APP2（ICC颜色配置）、APP14（Adobe，影响颜色转换）
+        var $keep = array(0xE0,0xE2,0xEE);
+
+        //读取SOS之前的全部段，返回 array(段列表,图像数据开始位置)，段为array(标记,内容)，不是JPEG返回false
+        function segments($fp){
+            if(fread($fp,2) !== "\xFF\xD8") {
+                return false;
+            }
+            $segments = array();
+            while(!feof($fp)) {
+                if(fread($fp,1) !== "\xFF") {
+                    return false;
+                }
+                //标记前可以有多个填充的0xFF
+                do {
+                    $marker = ord(fread($fp,1));
+                } while(($marker == 0xFF) && (!feof($fp)));
+                //图像数据开始，之后的内容原样复制
+                if($marker == 0xDA) {
+                    return array($segments,ftell($fp) - 2);
+                }
+                //没有长度的独立标记
+                if((($marker >= 0xD0) && ($marker <= 0xD7)) || ($marker == 0x01)) {
+                    $segments[] = array($marker,null);
+                    continue;
+                }
+                $length = fread($fp,2);
+                if(strlen($length) != 2) {
+                    return false;
+                }
+                $length = unpack('n',$length);
+                $length = $length[1] - 2;
+                if($length < 0) {
+                    return false;
+                }
+                $data = ($length > 0) ? fread($fp,$length) : '';
+                if(strlen($data) != $length) {
+                    return false;
+                }
+                $segments[] = array($marker,$data);
+            }
+            return false;
+        }
+        //读取整数，$le为小端字节序
+        function int($data,$pos,$size,$le){
+            $value = unpack(($size == 2) ? ($le ? 'v' : 'n') : ($le ? 'V' : 'N'),substr($data,$pos,$size));
+            return $value[1];
+        }
+        //读取一个IFD，返回 tag => array(类型,数量,数据位置)
+        function ifd($tiff,$offset,$le){
+            $tags = array();
+            $length = strlen($tiff);
+            if(($offset <= 0) || ($offset + 2 > $length)) {
+                return $tags;
+            }
+            //各类型每个值的字节数：BYTE、ASCII、SHORT、LONG、RATIONAL、UNDEFINED、SLONG、SRATIONAL
+            $sizes = array(1 => 1,2 => 1,3 => 2,4 => 4,5 => 8,7 => 1,9 => 4,10 => 8);
+            $count = $this->int($tiff,$offset,2,$le);
+            for($i = 0;$i < $count;$i++) {
+                $entry = $offset + 2 + $i * 12;
+                if($entry + 12 > $length) {
+                    break;
+                }
+                $type = $this->int($tiff,$entry + 2,2,$le);
+                if(!isset($sizes[$type])) {
+                    continue;
+                }
+                $num = $this->int($tiff,$entry + 4,4,$le);
+                $size = $sizes[$type] * $num;
+                //不超过4字节的值直接保存在条目中
+                $pos = ($size <= 4) ? $entry + 8 : $this->int($tiff,$entry + 8,4,$le);
+                if(($num > 65536) || ($pos + $size > $length)) {
+                    continue;
+                }
+                $tags[$this->int($tiff,$entry,2,$le)] = array($type,$num,$pos);
+            }
+            return $tags;
+        }
+        //读取tag的值，ASCII返回字符串，RATIONAL返回数组，其它返回整数
+        function value($tiff,$tag,$le){
+            list($type,$num,$pos) = $tag;
+            switch ($type) {
+                case 2:
+                    return trim(preg_replace('/[\x00-\x1F\x7F]/','',substr($tiff,$pos,$num)));
+                case 3:
+                    return $this->int($tiff,$pos,2,$le);
+                case 4:
+                    return $this->int($tiff,$pos,4,$le);
+                case 5:
+                    $values = array();
+                    for($i = 0;$i < $num;$i++) {
+                        $d = $this->int($tiff,$pos + $i * 8 + 4,4,$le);
+                        $values[] = ($d == 0) ? 0 : $this->int($tiff,$pos + $i * 8,4,$le) / $d;
+                    }
+                    return $values;
+                default:
+                    return null;
+            }
+        }
+        //GPS度分秒转换为小数，南纬、西经为负数
+        function coordinate($values,$ref){
+            if((!is_array($values)) || (count($values) < 3)) {
+                return null;
+            }
+            $value = round($values[0] + $values[1] / 60 + $values[2] / 3600,6);
+            return in_array(strtoupper($ref),array('S','W')) ? -$value : $value;
+        }
+        /*
+        读取JPEG的元数据，不是JPEG返回false
+        返回 orientation（1-8，没有时为0）、make、model（拍摄设备）、taken（拍摄时间 2018-05-06 12:00:00）、lat、lng（GPS坐标）
+        */
+        function read($file){
+            $fp = @fopen($file,'rb');
+            if(!$fp) {
+                return false;
+            }
+            $result = $this->segments($fp);
+            fclose($fp);
+            if($result === false) {
+                return false;
+            }
+            $meta = array("orientation" => 0,"make" => null,"model" => null,"taken" => null,"lat" => null,"lng" => null);
+            foreach ($result[0] as $segment) {
+                if(($segment[0] != 0xE1) || (substr($segment[1],0,6) !== "Exif\0\0")) {
+                    continue;
+                }
+                //TIFF头：II（小端）或MM（大端），第一个IFD的位置
+                $tiff = substr($segment[1],6);
+                if(strlen($tiff) < 8) {
+                    break;
+                }
+                $le = (substr($tiff,0,2) == 'II');
+                $ifd0 = $this->ifd($tiff,$this->int($tiff,4,4,$le),$le);
+                if(isset($ifd0[0x0112])) {
+                    $orientation = $this->value($tiff,$ifd0[0x0112],$le);
+                    $meta['orientation'] = (($orientation >= 1) && ($orientation <= 8)) ? $orientation : 0;
+                }
+                foreach (array(0x010F => "make",0x0110 => "model") as $id => $name) {
+                    if(isset($ifd0[$id]) && ($ifd0[$id][0] == 2)) {
+                        $meta[$name] = substr($this->value($tiff,$ifd0[$id],$le),0,64);
+                    }
+                }
+                //拍摄时间在EXIF子IFD中，格式为 2018:05:06 12:00:00
+                if(isset($ifd0[0x8769])) {
+                    $sub = $this->ifd($tiff,$this->value($tiff,$ifd0[0x8769],$le),$le);
+                    if(isset($sub[0x9003]) && preg_match('/^(\d{4}):(\d{2}):(\d{2}) (\d{2}:\d{2}:\d{2})/',$this->value($tiff,$sub[0x9003],$le),$match)) {
+                        $meta['taken'] = $match[1].'-'.$match[2].'-'.$match[3].' '.$match[4];
+                    }
+                }
+                //GPS子IFD：1纬度方向、2纬度、3经度方向、4经度
+                if(isset($ifd0[0x8825])) {
+                    $gps = $this->ifd($tiff,$this->value($tiff,$ifd0[0x8825],$le),$le);
+                    if(isset($gps[2]) && isset($gps[4])) {
+                        $meta['lat'] = $this->coordinate($this->value($tiff,$gps[2],$le),isset($gps[1]) ? $this->value($tiff,$gps[1],$le) : 'N');
+                        $meta['lng'] = $this->coordinate($this->value($tiff,$gps[4],$le),isset($gps[3]) ? $this->value($tiff,$gps[3],$le) : 'E');
+                    }
+                }
+                break;
+            }
+            return $meta;
+        }
+        //图片的旋转方向，没有时返回0
+        function orientation($file){
+            $meta = $this->read($file);
+            return ($meta === false) ? 0 : $meta['orientation'];
+        }
+        //只包含方向的EXIF段
+        function orientationsegment($orientation){
+            $data = "Exif\0\0"."MM\0\x2A".pack('N',8).pack('n',1).pack('nnN',0x0112,3,1).pack('nn',$orientation,0).pack('N',0);
+            return "\xFF\xE1".pack('n',strlen($data) + 2).$data;
+        }
+        /*
+        SOS开始到第一个EOI为止的图像数据，$data从SOS标记开始
+        手机照片在EOI之后附加的MPF副图、预览图等自带EXIF及GPS，不包含在内；没有EOI时返回全部数据
+        */
+        function imagedata($data){
+            $length = strlen($data);
+            $pos = 0;
+            while(($pos = strpos($data,"\xFF",$pos)) !== false) {
+                if($pos + 1 >= $length) {
+                    break;
+                }
+                $marker = ord($data[$pos + 1]);
+                //0x00为压缩数据中的填充，0xFF为多余的填充，RST没有长度
+                if(($marker == 0x00) || ($marker == 0xFF)) {
+                    $pos++;
+                    continue;
+                }
+                if(($marker >= 0xD0) && ($marker <= 0xD7)) {
+                    $pos += 2;
+                    continue;
+                }
+                if($marker == 0xD9) {
+                    return substr($data,0,$pos + 2);
+                }
+                //SOS、DHT等标记段按长度整段跳过，段内容中的0xFF不是标记
+                if($pos + 4 > $length) {
+                    break;
+                }
+                $size = unpack('n',substr($data,$pos + 2,2));
+                $pos += 2 + $size[1];
+            }
+            return $data;
+        }
+        /*
+        删除JPEG的元数据段（EXIF、XMP、IPTC、注释、MPF等）及EOI之后附加的数据，$orientation大于1时写入只包含方向的EXIF段
+        图像数据原样复制，不重新编码；返回减少的字节数，没有需要删除的内容时返回0，失败返回false
+        */
+        function strip($file,$orientation = 0){
+            $fp = @fopen($file,'rb');
+            if(!$fp) {
+                return false;
+            }
+            $result = $this->segments($fp);
+            if($result === false) {
+                fclose($fp);
+                return false;
+            }
+            list($segments,$start) = $result;
+            $header = "\xFF\xD8";
+            $removed = 0;
+            foreach ($segments as $i => $segment) {
+                list($marker,$data) = $segment;
+                //APP段及注释中只保留影响显示的段，APP2中的MPF（多图索引）同样删除
+                $meta = (($marker >= 0xE0) && ($marker <= 0xEF)) || ($marker == 0xFE);
+                if($meta && ((!in_array($marker,$this->keep)) || (($marker == 0xE2) && (substr($data,0,4) === "MPF\0")))) {
+                    $removed++;
+                    continue;
+                }
+                $header .= "\xFF".chr($marker).(is_null($data) ? '' : pack('n',strlen($data) + 2).$data);
+            }
+            fseek($fp,$start);
+            $rest = stream_get_contents($fp);
+            fclose($fp);
+            $image = $this->imagedata($rest);
+            //EOI之后附加的图片
+            if(strlen($image) < strlen($rest)) {
+                $removed++;
+            }
+            unset($rest);
+            if(($removed == 0) && ($orientation <= 1)) {
+                return 0;
+            }
+            //方向段放在SOI之后，有JFIF段时放在JFIF段之后
+            if($orientation > 1) {
+                $pos = ((!empty($segments)) && ($segments[0][0] == 0xE0)) ? 2 + 4 + strlen($segments[0][1]) : 2;
+                $header = substr($header,0,$pos).$this->orientationsegment($orientation).substr($header,$pos);
+            }
+            $before = filesize($file);
+            $tmpfile = $file.'.'.uniqid().'.tmp';
+            if(file_put_contents($tmpfile,$header.$image) === false) {
+                @unlink($tmpfile);
+                return false;
+            }
+            if(!rename($tmpfile,$file)) {
+                @unlink($tmpfile);
+                return false;
+            }
+            clearstatcache();
+            return $before - filesize($file);
+        }
+        //按EXIF方向旋转GD图片，GD解码时不会处理方向，返回旋转后的图片
+        function orient($im,$orientation){
+            //5、7为旋转后再水平翻转
+            $angles = array(3 => 180,5 => 270,6 => 270,7 => 90,8 => 90);
+            if(isset($angles[$orientation])) {
+                $rotated = imagerotate($im,$angles[$orientation],0);
+                if($rotated) {
+                    imagedestroy($im);
+                    $im = $rotated;
+                }
+            }
+            if(in_array($orientation,array(2,5,7))) {
+                imageflip($im,IMG_FLIP_HORIZONTAL);
+            }
+            else if($orientation == 4) {
+                imageflip($im,IMG_FLIP_VERTICAL);
+            }
+            return $im;
+        }
+        //按EXIF方向旋转Imagick图片，并将方向设置为正常，去除元数据后仍然正确显示
+        function imagick($im){
+            $orientation = $im->getImageOrientation();
+            //Imagick按顺时针旋转
+            $angles = array(3 => 180,5 => 90,6 => 90,7 => 270,8 => 270);
+            if(isset($angles[$orientation])) {
+                $im->rotateImage('#000',$angles[$orientation]);
+            }
+            if(in_array($orientation,array(2,5,7))) {
+                $im->flopImage();
+            }
+            else if($orientation == 4) {
+                $im->flipImage();
+            }
+            $im->setImageOrientation(Imagick::ORIENTATION_TOPLEFT);
+            return $im;
+        }
+    }
+?>
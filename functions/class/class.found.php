@@ -0,0 +1,42 @@
+<?php
+    /*
+    探索发现：随机抽取本月图片，避免ORDER BY random()扫描整个月的数据
+    随机数由PHP生成，查询只使用范围条件及LIMIT，SQLite/MySQL/PostgreSQL通用；可传入只读从库
+    */
+    class Found{
+        var $database;
+
+        public function __construct($database){
+            $this->database = $database;
+        }
+        //随机抽取$dir目录中$thetime（201805）月份的$num张图片
+        function sample($dir,$thetime,$num){
+            $database = $this->database;
+            $start = (int)($thetime.'00');
+            $end = (int)($thetime.'31');
+            //ID随上传时间递增，通过imginfo_day索引取本月第一张及最后一张图片的ID
+            $first = $database->query('SELECT "id" FROM "imginfo" WHERE "day" >= :start ORDER BY "day" ASC,"id" ASC LIMIT 1',[":start" => $start])->fetchColumn();
+            $last = $database->query('SELECT "id" FROM "imginfo" WHERE "day" <= :end ORDER BY "day" DESC,"id" DESC LIMIT 1',[":end" => $end])->fetchColumn();
+            if(($first === false) || ($last === false) || ($first > $last)) {
+                return array();
+            }
+            //ID范围较小时直接读取全部后打乱
+            if(($last - $first) < $num * 4) {
+                $sql = 'SELECT "id","path" FROM "imginfo" WHERE ("id" BETWEEN :first AND :last AND "dir" = :dir AND "level" < 3)';
+                $datas = $database->query($sql,[":first" => $first,":last" => $last,":dir" => $dir])->fetchAll();
+                shuffle($datas);
+                return array_slice($datas,0,$num);
+            }
+            //在ID范围内随机取点，每个点按主键向后查找一张符合条件的图片
+            $sql = 'SELECT "id","path" FROM "imginfo" WHERE ("id" >= :id AND "id" <= :last AND "dir" = :dir AND "level" < 3) ORDER BY "id" ASC LIMIT 1';
+            $datas = array();
+            for($i = 0;($i < $num * 2) && (count($datas) < $num);$i++) {
+                $img = $database->query($sql,[":id" => mt_rand($first,$last),":last" => $last,":dir" => $dir])->fetch();
+                if($img) {
+                    $datas[$img['id']] = $img;
+                }
+            }
+            return array_values($datas);
+        }
+    }
+?>
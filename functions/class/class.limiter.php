@@ -0,0 +1,188 @@
+<?php
+    /*
+    游客上传频率限制，令牌桶算法
+    每个IP最多连续上传limit张，之后按每天limit张的速度恢复；同一网段另有一个共享的令牌桶
+    支持 APCu/Redis/SQLite 三种存储方式，不可用时使用SQLite（使用MySQL/PostgreSQL时保存在对应的数据库）
+    访客IP使用REMOTE_ADDR，只有请求来自配置的反向代理时才使用X-Forwarded-For
+    */
+    class Limiter{
+        var $config;
+        var $database;
+        //令牌桶容量
+        var $capacity;
+        //每秒恢复的令牌数
+        var $rate;
+        //实际使用的存储方式
+        var $backend;
+        var $redis;
+
+        //构造函数，$config为配置文件中的$limiter，$limit为每天的上传数量
+        public function __construct($config,$database,$limit){
+            $this->config = $config;
+            $this->database = $database;
+            $this->capacity = $limit;
+            $this->rate = $limit / 86400;
+            $this->backend = $this->backend($config['backend']);
+        }
+        //选择存储方式
+        function backend($backend){
+            if(($backend == 'apcu') && function_exists('apcu_fetch') && ini_get('apc.enabled')) {
+                return 'apcu';
+            }
+            if(($backend == 'redis') && class_exists('Redis')) {
+                try {
+                    $redis = new Redis();
+                    $redis->connect($this->config['redis']['host'],$this->config['redis']['port'],1);
+                    if($this->config['redis']['password'] != '') {
+                        $redis->auth($this->config['redis']['password']);
+                    }
+                    $this->redis = $redis;
+                    return 'redis';
+                }
+                catch (Exception $e) {
+                    //连接失败使用SQLite
+                }
+            }
+            return 'sqlite';
+        }
+        //访客IP，请求来自$config['proxies']中的代理时，从X-Forwarded-For右侧开始取第一个不是代理的地址
+        function clientip(){
+            $ip = $_SERVER['REMOTE_ADDR'];
+            $proxies = (array)$this->config['proxies'];
+            if((!in_array($ip,$proxies)) || empty($_SERVER['HTTP_X_FORWARDED_FOR'])) {
+                return $ip;
+            }
+            foreach (array_reverse(explode(',',$_SERVER['HTTP_X_FORWARDED_FOR'])) as $forwarded) {
+                $forwarded = trim($forwarded);
+                if(!filter_var($forwarded,FILTER_VALIDATE_IP)) {
+                    break;
+                }
+                $ip = $forwarded;
+                if(!in_array($forwarded,$proxies)) {
+                    break;
+                }
+            }
+            return $ip;
+        }
+        //获取IP所在网段，IPv4为/24，IPv6为/64
+        function subnet($ip){
+            if(filter_var($ip,FILTER_VALIDATE_IP,FILTER_FLAG_IPV4)) {
+                return substr($ip,0,strrpos($ip,'.')).'.0/24';
+            }
+            if(filter_var($ip,FILTER_VALIDATE_IP,FILTER_FLAG_IPV6)) {
+                return bin2hex(substr(inet_pton($ip),0,8)).'/64';
+            }
+            return $ip;
+        }
+        //是否允许上传，允许时每张图片消耗一个令牌
+        function allow($ip,$num = 1){
+            if($this->capacity <= 0) {
+                return false;
+            }
+            if(!$this->take('ip:'.$ip,$this->capacity,$num)) {
+                return false;
+            }
+            if(!$this->take('net:'.$this->subnet($ip),$this->capacity * $this->config['subnet'],$num)) {
+                //网段额度不足时退回IP的令牌
+                $this->take('ip:'.$ip,$this->capacity,-$num);
+                return false;
+            }
+            return true;
+        }
+        //最多允许上传$num张，额度不足时允许剩余的数量，返回允许的数量
+        function grant($ip,$num){
+            for($i = min($num,(int)floor($this->capacity));$i > 0;$i--) {
+                if($this->allow($ip,$i)) {
+                    return $i;
+                }
+            }
+            return 0;
+        }
+        //从令牌桶中取出$num个令牌，不足时一个也不取；$num为负数时退回令牌
+        function take($key,$capacity,$num = 1){
+            $backend = $this->backend;
+            return $this->$backend($key,$capacity,$num,time());
+        }
+        //根据上次剩余令牌数及时间计算当前令牌数
+        function refill($tokens,$updated,$capacity,$now){
+            return min($capacity,$tokens + ($now - $updated) * $this->rate);
+        }
+        //APCu存储
+        function apcu($key,$capacity,$num,$now){
+            $key = 'imgurl_limit_'.$key;
+            $data = apcu_fetch($key);
+            $tokens = is_array($data) ? $this->refill($data[0],$data[1],$capacity,$now) : $capacity;
+            $allow = $tokens >= $num;
+            if($allow) {
+                $tokens -= $num;
+            }
+            apcu_store($key,array($tokens,$now),(int)ceil($capacity / $this->rate));
+            return $allow;
+        }
+        //Redis存储，使用Lua脚本保证原子性
+        function redis($key,$capacity,$num,$now){
+            $script = "local data = redis.call('HMGET', KEYS[1], 't', 'u')
+local capacity = tonumber(ARGV[1])
+local rate = tonumber(ARGV[2])
+local now = tonumber(ARGV[3])
+local num = tonumber(ARGV[4])
+local tokens = tonumber(data[1]) or capacity
+local updated = tonumber(data[2]) or now
+tokens = math.min(capacity, tokens + (now - updated) * rate)
+local allow = 0
+if tokens >= num then
+    tokens = tokens - num
+    allow = 1
+end
+redis.call('HMSET', KEYS[1], 't', tostring(tokens), 'u', now)
+redis.call('EXPIRE', KEYS[1], math.ceil(capacity / rate))
+return allow";
+            $result = $this->redis->eval($script,array($this->config['redis']['prefix'].$key,$capacity,$this->rate,$now,$num),1);
+            return $result == 1;
+        }
+        //SQLite存储（使用MySQL/PostgreSQL时为对应的数据库），不足时返回false，数据库出错时同样不允许上传
+        function sqlite($key,$capacity,$num,$now){
+            $result = $this->consume($key,$capacity,$num,$now);
+            if(is_null($result)) {
+                return false;
+            }
+            if($result) {
+                return true;
+            }
+            //记录存在说明令牌不足
+            if($this->database->has("limiter",["key" => $key])) {
+                return false;
+            }
+            if($capacity < $num) {
+                return false;
+            }
+            $this->database->insert("limiter",["key" => $key,"tokens" => $capacity - $num,"updated" => $now]);
+            $error = $this->database->error();
+            if($error[0] !== '00000') {
+                //其它请求同时写入了该记录，重新扣除一次
+                return $this->consume($key,$capacity,$num,$now) === true;
+            }
+            //偶尔清理已经恢复满的记录
+            if(mt_rand(1,100) == 1) {
+                $this->database->delete("limiter",["updated[<]" => $now - (int)ceil($this->capacity * max(1,$this->config['subnet']) / $this->rate)]);
+            }
+            return true;
+        }
+        /*
+        一条带条件的UPDATE完成恢复及扣除，并发请求不会读到同一个令牌数
+        成功返回true，记录不存在或令牌不足返回false，出错返回null
+        */
+        function consume($key,$capacity,$num,$now){
+            //恢复后的令牌数，参与计算的都是程序中的数值
+            $tokens = 'CASE WHEN "tokens" + ('.(int)$now.' - "updated") * '.sprintf('%.10F',$this->rate).' > '.sprintf('%.4F',$capacity).' THEN '.sprintf('%.4F',$capacity).' ELSE "tokens" + ('.(int)$now.' - "updated") * '.sprintf('%.10F',$this->rate).' END';
+            $statement = $this->database->query('UPDATE "limiter" SET "tokens" = '.$tokens.' - ('.(int)$num.'), "updated" = '.(int)$now.' WHERE "key" = :key AND '.$tokens.' >= ('.(int)$num.')',[
+                ":key"  =>  $key
+            ]);
+            $error = $this->database->error();
+            if((!$statement) || ($error[0] !== '00000')) {
+                return null;
+            }
+            return $statement->rowCount() > 0;
+        }
+    }
+?>
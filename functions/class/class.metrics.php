@@ -0,0 +1,141 @@
+<?php
+    /*
+    性能统计：记录数据库查询、图片处理及外部HTTP请求的耗时与字节数
+    每个请求结束时汇总到APCu，由metrics.php以Prometheus格式输出；可选输出Server-Timing响应头
+    */
+    class Metrics{
+        var $config;
+        //本次请求的统计：分组 => 标签 => array(次数,耗时微秒,字节数)
+        var $timings = array();
+        //请求开始时间（微秒）
+        var $start;
+
+        //构造函数，$config为配置文件中的$monitor
+        public function __construct($config){
+            $this->config = $config;
+            $this->start = $this->now();
+            if($config['option'] != true) {
+                return;
+            }
+            if(($config['header'] == true) && (php_sapi_name() != 'cli') && function_exists('header_register_callback')) {
+                //响应头在第一次输出时发送，此时大部分处理已经完成
+                header_register_callback(array($this,'header'));
+            }
+            register_shutdown_function(array($this,'flush'));
+        }
+        //当前时间，单位微秒
+        function now(){
+            return function_exists('hrtime') ? hrtime(true) / 1000 : microtime(true) * 1000000;
+        }
+        //是否开启
+        function enabled(){
+            return $this->config['option'] == true;
+        }
+        //记录一次耗时，$start为now()的返回值，$labels如array("op" => "select")
+        function stop($group,$start,$bytes = 0,$labels = array()){
+            if($this->config['option'] != true) {
+                return;
+            }
+            $this->add($group,$this->now() - $start,$bytes,$labels);
+        }
+        //记录已知的耗时（微秒），用于curl_getinfo等已经计算好的时间
+        function add($group,$us,$bytes = 0,$labels = array()){
+            if($this->config['option'] != true) {
+                return;
+            }
+            ksort($labels);
+            $key = $this->labels($labels);
+            if(!isset($this->timings[$group][$key])) {
+                $this->timings[$group][$key] = array(0,0,0);
+            }
+            $this->timings[$group][$key][0]++;
+            $this->timings[$group][$key][1] += $us;
+            $this->timings[$group][$key][2] += $bytes;
+        }
+        //Prometheus标签格式：op="select",table="imginfo"
+        function labels($labels){
+            $items = array();
+            foreach ($labels as $name => $value) {
+                $items[] = $name.'="'.str_replace(array('\\','"',"\n"),array('\\\\','\\"','\\n'),$value).'"';
+            }
+            return implode(',',$items);
+        }
+        //输出Server-Timing响应头，每个分组一项
+        function header(){
+            $items = array();
+            foreach ($this->timings as $group => $series) {
+                $calls = 0;
+                $us = 0;
+                foreach ($series as $value) {
+                    $calls += $value[0];
+                    $us += $value[1];
+                }
+                $items[] = $group.';dur='.round($us / 1000,2).';desc="'.$calls.'"';
+            }
+            $items[] = 'total;dur='.round(($this->now() - $this->start) / 1000,2);
+            header('Server-Timing: '.implode(', ',$items),false);
+        }
+        //APCu中的key
+        function key($name,$labels){
+            return $this->config['prefix'].$name.'{'.$labels.'}';
+        }
+        //APCu计数器累加，key不存在时创建
+        function inc($key,$step){
+            if(apcu_inc($key,$step) === false) {
+                if(!apcu_add($key,$step)) {
+                    apcu_inc($key,$step);
+                }
+            }
+        }
+        //请求结束时汇总到APCu
+        function flush(){
+            if((!function_exists('apcu_inc')) || (!ini_get('apc.enabled')) || ((php_sapi_name() == 'cli') && (!ini_get('apc.enable_cli')))) {
+                return;
+            }
+            foreach ($this->timings as $group => $series) {
+                foreach ($series as $labels => $value) {
+                    $this->inc($this->key('imgurl_'.$group.'_calls_total',$labels),$value[0]);
+                    $this->inc($this->key('imgurl_'.$group.'_seconds_total',$labels),(int)round($value[1]));
+                    if($value[2] > 0) {
+                        $this->inc($this->key('imgurl_'.$group.'_bytes_total',$labels),(int)$value[2]);
+                    }
+                }
+            }
+            //请求耗时直方图，按脚本名区分
+            $script = (php_sapi_name() == 'cli') ? basename($_SERVER['argv'][0]) : basename($_SERVER['SCRIPT_NAME']);
+            $seconds = ($this->now() - $this->start) / 1000000;
+            foreach ($this->config['buckets'] as $le) {
+                if($seconds <= $le) {
+                    $this->inc($this->key('imgurl_request_seconds_bucket',$this->labels(array("script" => $script,"le" => $le))),1);
+                }
+            }
+            $this->inc($this->key('imgurl_request_seconds_bucket',$this->labels(array("script" => $script,"le" => "+Inf"))),1);
+            $this->inc($this->key('imgurl_request_seconds_sum',$this->labels(array("script" => $script))),(int)round($seconds * 1000000));
+            $this->inc($this->key('imgurl_request_seconds_count',$this->labels(array("script" => $script))),1);
+        }
+        //以Prometheus文本格式输出APCu中的全部统计
+        function export(){
+            if((!class_exists('APCUIterator')) || (!ini_get('apc.enabled'))) {
+                return "# APCu未开启，无法汇总统计\n";
+            }
+            $families = array();
+            $prefix = $this->config['prefix'];
+            foreach (new APCUIterator('/^'.preg_quote($prefix,'/').'imgurl_/') as $item) {
+                $line = substr($item['key'],strlen($prefix));
+                $name = substr($line,0,strpos($line,'{'));
+                //计数器中的秒数以微秒保存
+                $value = (strpos($name,'_seconds') !== false) && (substr($name,-6) != '_count') && (substr($name,-7) != '_bucket') ? $item['value'] / 1000000 : $item['value'];
+                $family = preg_replace('/_(bucket|sum|count)$/','',$name);
+                $families[$family][] = str_replace('{}','',$line).' '.$value;
+            }
+            ksort($families);
+            $output = '';
+            foreach ($families as $family => $lines) {
+                sort($lines);
+                $output .= '# TYPE '.$family.' '.(($family == 'imgurl_request_seconds') ? 'histogram' : 'counter')."\n";
+                $output .= implode("\n",$lines)."\n";
+            }
+            return $output;
+        }
+    }
+?>
@@ -0,0 +1,299 @@
+<?php
+    /*
+    本地图片优化类，按 vips > Imagick > GD 自动选择可用的处理方式
+    JPEG：渐进式编码 + 指定质量；PNG：调色板量化 + 最高压缩级别
+    可去除元数据，并可额外生成同名的.webp/.avif文件（如：abc.jpg.webp）
+    */
+    class Optimizer{
+        var $config;
+        //实际使用的处理方式：vips/imagick/gd，不可用时为false
+        var $engine;
+        //最近一次处理失败的原因
+        var $error;
+        //读取JPEG方向，重新编码时按方向旋转，去除元数据后仍然正确显示
+        var $exif;
+
+        //构造函数，$config为配置文件中的$optimize
+        public function __construct($config){
+            $this->config = $config;
+            $this->engine = $this->engine($config['engine']);
+            $this->exif = new Exif();
+        }
+        //选择处理方式，指定的方式不可用时自动选择
+        function engine($engine){
+            $engines = array(
+                "vips"      =>  extension_loaded('vips'),
+                "imagick"   =>  class_exists('Imagick'),
+                "gd"        =>  function_exists('imagecreatefromjpeg')
+            );
+            if(($engine != 'auto') && (!empty($engines[$engine]))) {
+                return $engine;
+            }
+            foreach ($engines as $key => $value) {
+                if($value) {
+                    return $key;
+                }
+            }
+            return false;
+        }
+        //获取图片类型，仅支持JPEG和PNG
+        function type($file){
+            $info = @getimagesize($file);
+            if($info === false) {
+                return false;
+            }
+            switch ($info[2]) {
+                case IMAGETYPE_JPEG:
+                    return 'jpg';
+                case IMAGETYPE_PNG:
+                    return 'png';
+                default:
+                    return false;
+            }
+        }
+        //是否需要生成WebP/AVIF，只处理JPEG/PNG
+        function needvariant($file){
+            if($this->type($file) === false) {
+                return false;
+            }
+            foreach (array('webp','avif') as $format) {
+                if(($this->config[$format] == true) && (!is_file($file.'.'.$format))) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        //生成所有开启的WebP/AVIF格式
+        function variants($file){
+            $type = $this->type($file);
+            foreach (array('webp','avif') as $format) {
+                if($this->config[$format] == true) {
+                    $this->variant($file,$format,$type);
+                }
+            }
+        }
+        //优化图片并覆盖原图，$variant为false时不生成WebP/AVIF（交给后台任务），返回优化前后的大小，失败返回false
+        function run($file,$variant = true){
+            if($this->engine === false) {
+                $this->error = '没有可用的图片处理扩展！';
+                return false;
+            }
+            $type = $this->type($file);
+            if($type === false) {
+                $this->error = '该格式不支持优化！';
+                return false;
+            }
+            $before = filesize($file);
+            //临时文件保留图片后缀，vips根据后缀选择编码格式
+            $tmpfile = $file.'.'.uniqid().'.'.$type;
+            $engine = $this->engine;
+            if((!$this->$engine($file,$tmpfile,$type)) || (!is_file($tmpfile))) {
+                @unlink($tmpfile);
+                return false;
+            }
+            clearstatcache();
+            $after = filesize($tmpfile);
+            //优化后更小才覆盖原图
+            if(($after > 0) && ($after < $before) && rename($tmpfile,$file)) {
+                $saved = $before - $after;
+            }
+            else{
+                @unlink($tmpfile);
+                $after = $before;
+                $saved = 0;
+            }
+            //额外生成WebP/AVIF
+            if($variant) {
+                $this->variants($file);
+            }
+            return array(
+                "engine"    =>  $engine,
+                "before"    =>  $before,
+                "after"     =>  $after,
+                "saved"     =>  $saved
+            );
+        }
+        //生成同名的.webp/.avif文件，只在比原图更小时保留
+        function variant($file,$format,$type = null){
+            if(is_null($type)) {
+                $type = $this->type($file);
+            }
+            if(($this->engine === false) || ($type === false)) {
+                return false;
+            }
+            $dst = $file.'.'.$format;
+            $tmpfile = $file.'.'.uniqid().'.'.$format;
+            $method = $this->engine.'variant';
+            if((!$this->$method($file,$tmpfile,$format,$type)) || (!is_file($tmpfile))) {
+                @unlink($tmpfile);
+                return false;
+            }
+            clearstatcache();
+            if((filesize($tmpfile) > 0) && (filesize($tmpfile) < filesize($file))) {
+                return rename($tmpfile,$dst);
+            }
+            @unlink($tmpfile);
+            return false;
+        }
+        //vips读取图片，JPEG带有旋转方向时先旋转，旋转需要随机访问，不能使用sequential
+        function vipsload($src,$type){
+            $orientation = ($type == 'jpg') ? $this->exif->orientation($src) : 0;
+            if($orientation <= 1) {
+                return vips_image_new_from_file($src,["access" => "sequential"]);
+            }
+            $image = vips_image_new_from_file($src);
+            if(!is_array($image)) {
+                return $image;
+            }
+            $rotated = vips_call('autorot',$image['out']);
+            return is_array($rotated) ? $rotated : $image;
+        }
+        //使用vips优化
+        function vips($src,$dst,$type){
+            $image = $this->vipsload($src,$type);
+            if(!is_array($image)) {
+                $this->error = 'vips无法读取图片！';
+                return false;
+            }
+            if($type == 'jpg') {
+                $options = [
+                    "Q"                 =>  (int)$this->config['quality'],
+                    "strip"             =>  (bool)$this->config['strip'],
+                    "interlace"         =>  true,
+                    "optimize_coding"   =>  true
+                ];
+            }
+            else{
+                $options = [
+                    "compression"       =>  9,
+                    "palette"           =>  true,
+                    "Q"                 =>  (int)$this->config['quality'],
+                    "strip"             =>  (bool)$this->config['strip']
+                ];
+            }
+            if(vips_image_write_to_file($image['out'],$dst,$options) === -1) {
+                $this->error = 'vips保存图片失败！';
+                return false;
+            }
+            return true;
+        }
+        //使用vips生成WebP/AVIF
+        function vipsvariant($src,$dst,$format,$type){
+            $image = $this->vipsload($src,$type);
+            if(!is_array($image)) {
+                return false;
+            }
+            $options = [
+                "Q"         =>  (int)$this->config['quality'],
+                "strip"     =>  true
+            ];
+            //PNG使用无损WebP
+            if(($format == 'webp') && ($type == 'png')) {
+                $options['lossless'] = true;
+            }
+            return vips_image_write_to_file($image['out'],$dst,$options) !== -1;
+        }
+        //使用Imagick优化
+        function imagick($src,$dst,$type){
+            try {
+                $im = new Imagick($src);
+                $this->exif->imagick($im);
+                if($this->config['strip'] == true) {
+                    $im->stripImage();
+                }
+                if($type == 'jpg') {
+                    $im->setImageFormat('jpeg');
+                    $im->setImageCompressionQuality((int)$this->config['quality']);
+                    $im->setInterlaceScheme(Imagick::INTERLACE_PLANE);
+                    $im->setSamplingFactors(array('2x2','1x1','1x1'));
+                }
+                else{
+                    $im->setImageFormat('png');
+                    //颜色超过256种时量化为调色板图片
+                    if($im->getImageColors() > 256) {
+                        $im->quantizeImage(256,Imagick::COLORSPACE_SRGB,0,false,false);
+                    }
+                    $im->setOption('png:compression-level','9');
+                }
+                $im->writeImage($dst);
+                $im->clear();
+            }
+            catch (Exception $e) {
+                $this->error = $e->getMessage();
+                return false;
+            }
+            return true;
+        }
+        //使用Imagick生成WebP/AVIF
+        function imagickvariant($src,$dst,$format,$type){
+            if(count(Imagick::queryFormats(strtoupper($format))) == 0) {
+                return false;
+            }
+            try {
+                $im = new Imagick($src);
+                $this->exif->imagick($im);
+                $im->stripImage();
+                $im->setImageFormat($format);
+                $im->setImageCompressionQuality((int)$this->config['quality']);
+                if(($format == 'webp') && ($type == 'png')) {
+                    $im->setOption('webp:lossless','true');
+                }
+                $im->writeImage($dst);
+                $im->clear();
+            }
+            catch (Exception $e) {
+                return false;
+            }
+            return true;
+        }
+        //使用GD优化，GD重新编码后不保留任何元数据
+        function gd($src,$dst,$type){
+            if($type == 'jpg') {
+                $im = @imagecreatefromjpeg($src);
+                if(!$im) {
+                    $this->error = 'GD无法读取图片！';
+                    return false;
+                }
+                $im = $this->exif->orient($im,$this->exif->orientation($src));
+                imageinterlace($im,true);
+                $result = imagejpeg($im,$dst,(int)$this->config['quality']);
+            }
+            else{
+                $im = @imagecreatefrompng($src);
+                if(!$im) {
+                    $this->error = 'GD无法读取图片！';
+                    return false;
+                }
+                imagealphablending($im,false);
+                imagesavealpha($im,true);
+                $result = imagepng($im,$dst,9);
+            }
+            imagedestroy($im);
+            return $result;
+        }
+        //使用GD生成WebP/AVIF
+        function gdvariant($src,$dst,$format,$type){
+            $function = 'image'.$format;
+            if(!function_exists($function)) {
+                return false;
+            }
+            $im = ($type == 'jpg') ? @imagecreatefromjpeg($src) : @imagecreatefrompng($src);
+            if(!$im) {
+                return false;
+            }
+            if($type == 'jpg') {
+                $im = $this->exif->orient($im,$this->exif->orientation($src));
+            }
+            imagealphablending($im,false);
+            imagesavealpha($im,true);
+            $quality = (int)$this->config['quality'];
+            //PNG使用无损WebP（PHP 8.1+）
+            if(($format == 'webp') && ($type == 'png') && defined('IMG_WEBP_LOSSLESS')) {
+                $quality = IMG_WEBP_LOSSLESS;
+            }
+            $result = $function($im,$dst,$quality);
+            imagedestroy($im);
+            return $result;
+        }
+    }
+?>
@@ -0,0 +1,40 @@
+<?php
+    /*
+    阿里云OSS，接口与S3基本一致（包括分片上传），只有域名与签名方式不同
+    */
+    class OssStorage extends S3Storage{
+        var $name = 'oss';
+
+        //OSS只支持bucket.endpoint形式的域名
+        function target($key){
+            $config = $this->config[$this->name];
+            $endpoint = (strpos($config['endpoint'],'://') === false) ? 'https://'.$config['endpoint'] : $config['endpoint'];
+            $endpoint = parse_url($endpoint);
+            $path = '/'.implode('/',array_map('rawurlencode',explode('/',$key)));
+            return array($endpoint['scheme'],$config['bucket'].'.'.$endpoint['host'],$path);
+        }
+        //OSS签名：VERB\nContent-MD5\nContent-Type\nDate\nCanonicalizedOSSHeaders + CanonicalizedResource
+        function sign($method,$key,$host,$path,$query,$headers){
+            $config = $this->config[$this->name];
+            $headers['host'] = $host;
+            $headers['date'] = gmdate('D, d M Y H:i:s \G\M\T');
+            ksort($headers);
+            $oss = '';
+            foreach ($headers as $name => $value) {
+                if(strpos($name,'x-oss-') === 0) {
+                    $oss .= $name.':'.trim($value)."\n";
+                }
+            }
+            //分片上传相关的子资源需要参与签名
+            ksort($query);
+            $params = array();
+            foreach ($query as $name => $value) {
+                $params[] = ($value === '') ? $name : $name.'='.$value;
+            }
+            $resource = '/'.$config['bucket'].'/'.$key.(empty($params) ? '' : '?'.implode('&',$params));
+            $string = $method."\n".$headers['content-md5']."\n".$headers['content-type']."\n".$headers['date']."\n".$oss.$resource;
+            $headers['authorization'] = 'OSS '.$config['key'].':'.base64_encode(hash_hmac('sha1',$string,$config['secret'],true));
+            return $headers;
+        }
+    }
+?>
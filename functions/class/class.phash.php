@@ -0,0 +1,83 @@
+<?php
+    /*
+    图片感知hash（dHash），用于识别内容相同但文件不同的图片（重新压缩、缩放、改格式）
+    64位hash保存为16位十六进制，并拆分为4段16位整数分别建立索引：
+    汉明距离不超过3的两个hash至少有一段完全相同，按段查询候选后再计算距离
+    */
+    class Phash{
+        //最大可查询的汉明距离，等于分段数量 - 1
+        var $maxdistance = 3;
+
+        //计算图片的dHash，失败返回false
+        function file($file){
+            $pixels = $this->gray($file);
+            if($pixels === false) {
+                return false;
+            }
+            //每行9个像素比较相邻亮度得到8位，共8行
+            $hash = '';
+            for($y = 0;$y < 8;$y++) {
+                $byte = 0;
+                for($x = 0;$x < 8;$x++) {
+                    $byte = ($byte << 1) | (($pixels[$y * 9 + $x] < $pixels[$y * 9 + $x + 1]) ? 1 : 0);
+                }
+                $hash .= sprintf('%02x',$byte);
+            }
+            return $hash;
+        }
+        //缩小为9x8并返回灰度值，Imagick可在解码JPEG时直接缩小，速度更快
+        function gray($file){
+            if(class_exists('Imagick',false)) {
+                try {
+                    $image = new Imagick();
+                    $image->setOption('jpeg:size','72x64');
+                    $image->readImage($file.'[0]');
+                    $image->setImageColorspace(Imagick::COLORSPACE_GRAY);
+                    $image->resizeImage(9,8,Imagick::FILTER_BOX,1);
+                    $pixels = array();
+                    foreach ($image->exportImagePixels(0,0,9,8,'I',Imagick::PIXEL_CHAR) as $value) {
+                        $pixels[] = $value;
+                    }
+                    $image->clear();
+                    return (count($pixels) == 72) ? $pixels : false;
+                } catch (Exception $e) {
+                    //Imagick不支持的格式交给GD处理
+                }
+            }
+            $data = @file_get_contents($file);
+            $src = ($data === false) ? false : @imagecreatefromstring($data);
+            unset($data);
+            if(!$src) {
+                return false;
+            }
+            $image = imagecreatetruecolor(9,8);
+            imagecopyresampled($image,$src,0,0,0,0,9,8,imagesx($src),imagesy($src));
+            imagedestroy($src);
+            $pixels = array();
+            for($y = 0;$y < 8;$y++) {
+                for($x = 0;$x < 9;$x++) {
+                    $rgb = imagecolorat($image,$x,$y);
+                    $pixels[] = (($rgb >> 16) & 0xFF) * 0.299 + (($rgb >> 8) & 0xFF) * 0.587 + ($rgb & 0xFF) * 0.114;
+                }
+            }
+            imagedestroy($image);
+            return $pixels;
+        }
+        //拆分为4段16位整数，对应imginfo的ph1-ph4字段
+        function bands($hash){
+            $bands = array();
+            for($i = 0;$i < 4;$i++) {
+                $bands['ph'.($i + 1)] = hexdec(substr($hash,$i * 4,4));
+            }
+            return $bands;
+        }
+        //两个hash的汉明距离
+        function distance($a,$b){
+            $distance = 0;
+            for($i = 0;$i < 16;$i += 4) {
+                $distance += substr_count(decbin(hexdec(substr($a,$i,4)) ^ hexdec(substr($b,$i,4))),'1');
+            }
+            return $distance;
+        }
+    }
+?>
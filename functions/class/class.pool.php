@@ -0,0 +1,127 @@
+<?php
+    /*
+    HTTP连接池，使用curl_multi并发发送一组请求
+    同时进行的请求数量受concurrency限制，同一个multi句柄复用连接（keep-alive），失败的请求按间隔递增重试
+    */
+    class Pool{
+        var $config;
+        var $multi;
+
+        //构造函数，$config包含concurrency（并发数）、retries（重试次数）、timeout（单个请求超时时间，秒）
+        public function __construct($config){
+            $this->config = $config;
+            $this->multi = curl_multi_init();
+            //连接缓存数量，请求完成后连接留给下一个请求使用
+            if(defined('CURLMOPT_MAXCONNECTS')) {
+                curl_multi_setopt($this->multi,CURLMOPT_MAXCONNECTS,max(1,(int)$config['concurrency']) * 2);
+            }
+            //支持HTTP/2的服务器在同一连接上并发
+            if(defined('CURLMOPT_PIPELINING') && defined('CURLPIPE_MULTIPLEX')) {
+                curl_multi_setopt($this->multi,CURLMOPT_PIPELINING,CURLPIPE_MULTIPLEX);
+            }
+        }
+        public function __destruct(){
+            curl_multi_close($this->multi);
+        }
+        //curl句柄在PHP 8中为对象，统一转换为数字标识
+        function id($handle){
+            return is_object($handle) ? spl_object_id($handle) : (int)$handle;
+        }
+        //创建请求句柄，$options为curl选项
+        function handle($options){
+            $handle = curl_init();
+            $defaults = array(
+                CURLOPT_RETURNTRANSFER  =>  true,
+                CURLOPT_FOLLOWLOCATION  =>  true,
+                CURLOPT_CONNECTTIMEOUT  =>  10,
+                CURLOPT_TIMEOUT         =>  (int)$this->config['timeout'],
+                CURLOPT_USERAGENT       =>  "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/66.0.3359.139 Safari/537.36"
+            );
+            if(defined('CURLOPT_TCP_KEEPALIVE')) {
+                $defaults[CURLOPT_TCP_KEEPALIVE] = 1;
+            }
+            curl_setopt_array($handle,$options + $defaults);
+            return $handle;
+        }
+        //记录请求耗时及上传下载的字节数，按域名区分
+        static function metrics($handle){
+            global $metrics;
+            $metrics->add('http',curl_getinfo($handle,CURLINFO_TOTAL_TIME) * 1000000,curl_getinfo($handle,CURLINFO_SIZE_UPLOAD) + curl_getinfo($handle,CURLINFO_SIZE_DOWNLOAD),array(
+                "host"  =>  (string)parse_url(curl_getinfo($handle,CURLINFO_EFFECTIVE_URL),PHP_URL_HOST)
+            ));
+        }
+        //是否需要重试：网络错误、请求过于频繁或服务器错误
+        function retry($result){
+            return ($result['error'] != '') || ($result['status'] == 429) || ($result['status'] >= 500);
+        }
+        /*
+        并发执行请求，$requests为 key => curl选项
+        返回 key => array(status,body,error)，所有请求完成（含重试）后返回
+        */
+        function run($requests){
+            $results = array();
+            //等待发送的请求：key、已尝试次数、最早发送时间
+            $waiting = array();
+            foreach ($requests as $key => $options) {
+                $waiting[] = array($key,0,0);
+            }
+            $running = array();
+            $concurrency = max(1,(int)$this->config['concurrency']);
+
+            while((!empty($waiting)) || (!empty($running))) {
+                //补充请求直到达到并发数量
+                $now = microtime(true);
+                foreach ($waiting as $i => $item) {
+                    if(count($running) >= $concurrency) {
+                        break;
+                    }
+                    if($item[2] > $now) {
+                        continue;
+                    }
+                    $handle = $this->handle($requests[$item[0]]);
+                    curl_multi_add_handle($this->multi,$handle);
+                    $running[$this->id($handle)] = array($item[0],$item[1] + 1,$handle);
+                    unset($waiting[$i]);
+                }
+                //只剩等待重试的请求
+                if(empty($running)) {
+                    usleep(100000);
+                    continue;
+                }
+
+                do {
+                    $code = curl_multi_exec($this->multi,$active);
+                } while($code == CURLM_CALL_MULTI_PERFORM);
+                if(curl_multi_select($this->multi,1.0) == -1) {
+                    usleep(1000);
+                }
+
+                while($info = curl_multi_info_read($this->multi)) {
+                    $handle = $info['handle'];
+                    list($key,$attempts) = $running[$this->id($handle)];
+                    unset($running[$this->id($handle)]);
+                    $result = array(
+                        "status"    =>  (int)curl_getinfo($handle,CURLINFO_HTTP_CODE),
+                        "body"      =>  (string)curl_multi_getcontent($handle),
+                        "error"     =>  ($info['result'] == CURLE_OK) ? '' : curl_error($handle)
+                    );
+                    if(($info['result'] != CURLE_OK) && ($result['error'] == '')) {
+                        $result['error'] = 'curl error '.$info['result'];
+                    }
+                    self::metrics($handle);
+                    curl_multi_remove_handle($this->multi,$handle);
+                    curl_close($handle);
+
+                    if($this->retry($result) && ($attempts <= (int)$this->config['retries'])) {
+                        //重试间隔：0.5s、1s、2s...
+                        $waiting[] = array($key,$attempts,microtime(true) + 0.5 * pow(2,$attempts - 1));
+                    }
+                    else{
+                        $results[$key] = $result;
+                    }
+                }
+            }
+            return $results;
+        }
+    }
+?>
@@ -0,0 +1,153 @@
+<?php
+    /*
+    后台任务队列，任务保存在queue表
+    status：0 待处理，1 处理中，2 已完成，3 已失败
+    */
+    class Queue{
+        var $config;
+        var $database;
+
+        //构造函数，$config为配置文件中的$queue
+        public function __construct($config,$database){
+            $this->config = $config;
+            $this->database = $database;
+        }
+        /*
+        写入任务，同一目标的同类任务只保留一条，已有任务时（无论状态）直接返回其ID
+        dispose.php等任何人都可以调用的入口使用该方法，不会重新执行已完成或已失败的任务
+        */
+        function add($type,$target,$data = null){
+            $id = $this->database->get("queue","id",[
+                "type"      =>  $type,
+                "target"    =>  $target
+            ]);
+            if($id) {
+                return $id;
+            }
+            $this->database->insert("queue",[
+                "type"      =>  $type,
+                "target"    =>  $target,
+                "data"      =>  is_null($data) ? null : json_encode($data),
+                "status"    =>  0,
+                "attempts"  =>  0,
+                "runat"     =>  time(),
+                "lease"     =>  0,
+                "created"   =>  time()
+            ]);
+            return $this->database->id();
+        }
+        //写入任务，已完成或已失败的任务重新设置为待处理，只用于后台批量操作及命令行等管理员主动执行的操作
+        function push($type,$target,$data = null){
+            $job = $this->database->get("queue",["id","status"],[
+                "type"      =>  $type,
+                "target"    =>  $target
+            ]);
+            if(!$job) {
+                return $this->add($type,$target,$data);
+            }
+            if(in_array($job['status'],array(2,3))) {
+                $this->database->update("queue",[
+                    "data"      =>  is_null($data) ? null : json_encode($data),
+                    "status"    =>  0,
+                    "attempts"  =>  0,
+                    "runat"     =>  time(),
+                    "lease"     =>  0,
+                    "owner"     =>  null,
+                    "error"     =>  null
+                ],[
+                    "id"        =>  $job['id'],
+                    "status"    =>  [2,3]
+                ]);
+            }
+            return $job['id'];
+        }
+        //查询某个目标是否还有未完成的任务
+        function pending($target,$type = null){
+            $where = [
+                "target"    =>  $target,
+                "status"    =>  [0,1]
+            ];
+            if(!is_null($type)) {
+                $where['type'] = $type;
+            }
+            return $this->database->count("queue",$where) > 0;
+        }
+        //领取一批任务，租约到期仍未完成的任务可以被其它进程重新领取
+        function claim($num = null){
+            if(is_null($num)) {
+                $num = $this->config['batch'];
+            }
+            $now = time();
+            //已达到重试次数仍未完成（如处理时进程崩溃）的任务设置为失败，不再反复领取
+            $this->database->update("queue",[
+                "status"    =>  3,
+                "error"     =>  "lease expired"
+            ],[
+                "status"        =>  1,
+                "lease[<]"      =>  $now,
+                "attempts[>=]"  =>  (int)$this->config['attempts']
+            ]);
+            //本次领取的标识
+            $owner = uniqid(getmypid().'.',true);
+            $where = '("status" = 0 AND "runat" <= :now1) OR ("status" = 1 AND "lease" < :now2 AND "attempts" < :attempts)';
+            switch ($this->database->type()) {
+                //MySQL不支持在IN子查询中使用LIMIT，直接UPDATE ... LIMIT
+                case 'mysql':
+                    $sql = 'UPDATE "queue" SET "status" = 1, "owner" = :owner, "lease" = :lease, "attempts" = "attempts" + 1 WHERE '.$where.' ORDER BY "id" LIMIT :num';
+                    break;
+                //PostgreSQL跳过其它进程正在领取的任务，多个worker不会互相等待
+                case 'pgsql':
+                    $sql = 'UPDATE "queue" SET "status" = 1, "owner" = :owner, "lease" = :lease, "attempts" = "attempts" + 1 WHERE "id" IN (SELECT "id" FROM "queue" WHERE '.$where.' ORDER BY "id" LIMIT :num FOR UPDATE SKIP LOCKED)';
+                    break;
+                default:
+                    $sql = 'UPDATE "queue" SET "status" = 1, "owner" = :owner, "lease" = :lease, "attempts" = "attempts" + 1 WHERE "id" IN (SELECT "id" FROM "queue" WHERE '.$where.' ORDER BY "id" LIMIT :num)';
+                    break;
+            }
+            $this->database->query($sql,[
+                ":owner"    =>  $owner,
+                ":lease"    =>  $now + (int)$this->config['lease'],
+                ":now1"     =>  $now,
+                ":now2"     =>  $now,
+                ":attempts" =>  (int)$this->config['attempts'],
+                ":num"      =>  (int)$num
+            ]);
+            return $this->database->select("queue","*",[
+                "owner"     =>  $owner,
+                "status"    =>  1,
+                "ORDER"     =>  ["id" => "ASC"]
+            ]);
+        }
+        //任务完成，只更新本进程领取的任务，租约过期后已被其它进程重新领取的不处理
+        function done($job){
+            $this->database->update("queue",[
+                "status"    =>  2,
+                "error"     =>  null
+            ],[
+                "id"        =>  $job['id'],
+                "owner"     =>  $job['owner']
+            ]);
+        }
+        //任务失败，未超过重试次数时延后重新执行，同样只更新本进程领取的任务
+        function fail($job,$error){
+            $attempts = $job['attempts'];
+            if($attempts >= $this->config['attempts']) {
+                $data = [
+                    "status"    =>  3,
+                    "error"     =>  $error
+                ];
+            }
+            else{
+                //重试间隔逐次递增：30s、120s、270s...
+                $data = [
+                    "status"    =>  0,
+                    "runat"     =>  time() + $attempts * $attempts * 30,
+                    "error"     =>  $error
+                ];
+            }
+            $this->database->update("queue",$data,[
+                "id"        =>  $job['id'],
+                "owner"     =>  $job['owner']
+            ]);
+        }
+    }
+?>
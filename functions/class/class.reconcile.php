@@ -0,0 +1,300 @@
+<?php
+    /*
+    图片文件与数据库对账
+    files：逐个目录列出上传目录中的文件，分批通过imginfo_path索引查询，找出没有数据库记录的文件（orphan）及处理中断留下的临时文件（garbage）
+           只扫描本地目录，使用S3/OSS时对象存储中没有本地文件的孤立对象不会被发现
+    rows：按ID分批检查imginfo中的图片文件是否存在，找出文件已丢失的记录（dangling）
+    每批处理完成后保存断点，中断后从断点继续；文件检查速度受iops限制，可以在生产环境运行
+    */
+    class Reconcile{
+        var $config;
+        var $database;
+        //图片存储
+        var $store;
+        //扫描的上传目录
+        var $dirs;
+        //断点及统计
+        var $state;
+        //true时删除找到的文件及记录，否则只输出报告
+        var $purge = false;
+        //运行截止时间，到达后保存断点退出，0为不限制
+        var $deadline = 0;
+        //为防止误删而停止时的原因
+        var $aborted = '';
+        //限速：开始时间及已检查的文件数量
+        var $started;
+        var $ops = 0;
+        //图片及WebP/AVIF文件的扩展名，其它文件（如.htaccess）不处理
+        var $exts = array('jpg','jpeg','png','gif','bmp','webp','avif','tmp');
+
+        //构造函数，$config为配置文件中的$reconcile，$dirs为要扫描的目录（相对网站目录）
+        public function __construct($config,$database,$store,$dirs){
+            $this->config = $config;
+            $this->database = $database;
+            $this->store = $store;
+            //按名称顺序扫描，与断点的比较方式一致
+            sort($dirs,SORT_STRING);
+            $this->dirs = $dirs;
+            $this->started = microtime(true);
+            $this->load();
+        }
+        //断点文件路径
+        function file(){
+            return APP.$this->config['checkpoint'];
+        }
+        //读取断点，没有断点时从头开始
+        function load(){
+            $state = is_file($this->file()) ? json_decode(file_get_contents($this->file()),true) : null;
+            if(!is_array($state)) {
+                $state = array(
+                    "started"   =>  time(),
+                    "files"     =>  array("unit" => "","file" => "","done" => false),
+                    "rows"      =>  array("id" => 0,"done" => false),
+                    "stats"     =>  array("files" => 0,"rows" => 0,"orphan" => 0,"orphan_bytes" => 0,"garbage" => 0,"garbage_bytes" => 0,"dangling" => 0)
+                );
+            }
+            $this->state = $state;
+        }
+        //保存断点，先写临时文件再更名
+        function save(){
+            $file = $this->file();
+            if(!is_dir(dirname($file))) {
+                @mkdir(dirname($file),0777,true);
+            }
+            $tmpfile = $file.'.'.uniqid().'.tmp';
+            if(file_put_contents($tmpfile,json_encode($this->state)) !== false) {
+                rename($tmpfile,$file);
+            }
+        }
+        //删除断点，下次重新开始
+        function reset(){
+            @unlink($this->file());
+            $this->load();
+        }
+        //按iops限速，$num为本次检查的文件数量
+        function throttle($num){
+            $this->ops += $num;
+            if((int)$this->config['iops'] <= 0) {
+                return;
+            }
+            $wait = $this->ops / (int)$this->config['iops'] - (microtime(true) - $this->started);
+            if($wait > 0) {
+                usleep((int)($wait * 1000000));
+            }
+        }
+        //是否已到截止时间
+        function expired(){
+            return ($this->deadline > 0) && (time() >= $this->deadline);
+        }
+        //目录排序用的key，'/'替换为"\0"，使字符串顺序与先序遍历的顺序一致
+        function sortkey($path){
+            return str_replace('/',"\0",$path);
+        }
+        //输出一条结果，$purge为true时删除
+        function found($type,$path,$size){
+            echo $type."\t".$path."\t".$size."\n";
+            $this->state['stats'][$type]++;
+            $this->state['stats'][$type.'_bytes'] += (int)$size;
+            if($this->purge) {
+                //临时文件只在本地，孤立文件同时删除对象存储中的文件
+                if($type == 'garbage') {
+                    @unlink(APP.$path);
+                }
+                else{
+                    $this->store->delete($path);
+                }
+            }
+        }
+        //依次执行$phases中的步骤，全部完成返回true，到达截止时间返回false
+        function run($phases){
+            foreach ($phases as $phase) {
+                if($this->state[$phase]['done']) {
+                    continue;
+                }
+                if(!$this->$phase()) {
+                    $this->save();
+                    return false;
+                }
+                $this->state[$phase]['done'] = true;
+                $this->save();
+            }
+            return true;
+        }
+        //扫描全部上传目录
+        function files(){
+            foreach ($this->dirs as $dir) {
+                if(!$this->walk($dir)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        //先处理目录中的文件，再按名称顺序处理子目录；断点之前已完成的子目录不再列出
+        function walk($dir){
+            $key = $this->sortkey($dir);
+            $last = $this->sortkey($this->state['files']['unit']);
+            //整个目录都在断点之前
+            if(($last != '') && (strcmp($key,$last) < 0) && (strpos($last,$key."\0") !== 0)) {
+                return true;
+            }
+            $names = @scandir(APP.$dir);
+            if($names === false) {
+                return true;
+            }
+            sort($names,SORT_STRING);
+            $files = array();
+            $subdirs = array();
+            foreach ($names as $name) {
+                if(($name == '.') || ($name == '..')) {
+                    continue;
+                }
+                if(is_dir(APP.$dir.'/'.$name)) {
+                    $subdirs[] = $name;
+                }
+                else{
+                    $files[] = $name;
+                }
+            }
+            $this->throttle(count($subdirs));
+            //断点在该目录之前时处理全部文件，断点就是该目录时从上次的文件之后继续，断点在子目录中时文件已处理
+            if(($last == '') || (strcmp($key,$last) > 0)) {
+                $result = $this->unit($dir,$files,'');
+            }
+            else if($key == $last) {
+                $result = $this->unit($dir,$files,$this->state['files']['file']);
+            }
+            else{
+                $result = true;
+            }
+            if(!$result) {
+                return false;
+            }
+            foreach ($subdirs as $name) {
+                if(!$this->walk($dir.'/'.$name)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        //分批处理一个目录中的文件，$after为断点中上次处理到的文件名
+        function unit($dir,$files,$after){
+            $this->state['files']['unit'] = $dir;
+            $this->state['files']['file'] = $after;
+            $batch = array();
+            foreach ($files as $name) {
+                if(($after != '') && (strcmp($name,$after) <= 0)) {
+                    continue;
+                }
+                $batch[] = $name;
+                if(count($batch) >= (int)$this->config['batch']) {
+                    $this->check($dir,$batch);
+                    $batch = array();
+                    if($this->expired()) {
+                        return false;
+                    }
+                }
+            }
+            if(!empty($batch)) {
+                $this->check($dir,$batch);
+            }
+            return !$this->expired();
+        }
+        //检查一批文件，WebP/AVIF（abc.jpg.webp）按原图路径查询
+        function check($dir,$names){
+            $this->throttle(count($names));
+            $bases = array();
+            $sizes = array();
+            foreach ($names as $name) {
+                $ext = strtolower(pathinfo($name,PATHINFO_EXTENSION));
+                if(!in_array($ext,$this->exts)) {
+                    continue;
+                }
+                $path = $dir.'/'.$name;
+                $stat = @stat(APP.$path);
+                //宽限期内的文件可能正在上传或处理
+                if(($stat === false) || ($stat['mtime'] > time() - (int)$this->config['grace'])) {
+                    continue;
+                }
+                //优化、压缩、下载时写入的临时文件：原文件名.uniqid.扩展名
+                if(preg_match('/\.[0-9a-f]{13}\.[a-z0-9]+$/i',$name)) {
+                    $this->found('garbage',$path,$stat['size']);
+                    continue;
+                }
+                $bases[$path] = preg_match('/^(.+\.(jpg|jpeg|png|gif|bmp|webp))\.(webp|avif)$/i',$path,$match) ? $match[1] : $path;
+                $sizes[$path] = $stat['size'];
+            }
+            if(!empty($bases)) {
+                $exists = array_flip($this->database->select("imginfo","path",[
+                    "path"  =>  array_values(array_unique($bases))
+                ]));
+                foreach ($bases as $path => $base) {
+                    if(!isset($exists[$base])) {
+                        $this->found('orphan',$path,$sizes[$path]);
+                    }
+                }
+            }
+            $this->state['stats']['files'] += count($names);
+            $this->state['files']['file'] = end($names);
+            $this->save();
+        }
+        /*
+        删除记录前的检查：上传目录不存在或为空（未挂载、正在从备份恢复等）时不删除任何记录
+        使用对象存储时本地目录可以为空，不检查
+        */
+        function safe(){
+            if($this->store->remote()) {
+                return true;
+            }
+            foreach ($this->dirs as $dir) {
+                $names = @scandir(APP.$dir);
+                if(($names === false) || (count(array_diff($names,array('.','..','.htaccess'))) == 0)) {
+                    $this->aborted = '上传目录'.$dir.'不存在或为空，请确认已挂载';
+                    return false;
+                }
+            }
+            return true;
+        }
+        //按ID分批检查数据库记录对应的文件是否存在
+        function rows(){
+            global $pagecache;
+            if($this->purge && (!$this->safe())) {
+                return false;
+            }
+            while(!$this->expired()) {
+                $datas = $this->database->select("imginfo",["id","path"],[
+                    "id[>]"     =>  (int)$this->state['rows']['id'],
+                    "ORDER"     =>  ["id" => "ASC"],
+                    "LIMIT"     =>  (int)$this->config['batch']
+                ]);
+                if(empty($datas)) {
+                    return true;
+                }
+                $missing = array();
+                foreach ($datas as $img) {
+                    $this->throttle(1);
+                    //无法确定是否存在（网络错误）时不处理
+                    if($this->store->exists($img['path']) === false) {
+                        echo "dangling\t".$img['path']."\t#".$img['id']."\n";
+                        $missing[] = (int)$img['id'];
+                    }
+                }
+                //一批中丢失的比例过高时可能是存储异常，停止删除并保留断点，确认后可使用--phase=rows重新执行
+                $ratio = count($missing) / count($datas);
+                if($this->purge && (count($datas) >= 20) && ($ratio > (float)$this->config['maxmissing'])) {
+                    $this->aborted = '第'.$datas[0]['id'].'条记录开始的一批中'.round($ratio * 100).'%的图片文件不存在，超过'.round($this->config['maxmissing'] * 100).'%，已停止删除';
+                    return false;
+                }
+                $this->state['stats']['dangling'] += count($missing);
+                if($this->purge && (!empty($missing))) {
+                    $this->database->delete("imginfo",["id" => $missing]);
+                    $pagecache->invalidate();
+                }
+                $last = end($datas);
+                $this->state['rows']['id'] = (int)$last['id'];
+                $this->state['stats']['rows'] += count($datas);
+                $this->save();
+            }
+            return false;
+        }
+    }
+?>
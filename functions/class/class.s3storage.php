@@ -0,0 +1,246 @@
+<?php
+    /*
+    兼容S3的对象存储（AWS S3、MinIO、腾讯云COS等），使用AWS签名V4
+    文件从磁盘流式上传，超过partsize的文件使用分片上传，不会整个读入内存
+    */
+    class S3Storage extends Storage{
+        //对应配置文件$storage中的设置项
+        var $name = 's3';
+
+        //是否为对象存储
+        function remote(){
+            return true;
+        }
+        //返回请求的域名及路径
+        function target($key){
+            $config = $this->config[$this->name];
+            $endpoint = parse_url($config['endpoint']);
+            $path = '/'.implode('/',array_map('rawurlencode',explode('/',$key)));
+            if($config['pathstyle'] == true) {
+                return array($endpoint['scheme'],$endpoint['host'],'/'.$config['bucket'].$path);
+            }
+            return array($endpoint['scheme'],$config['bucket'].'.'.$endpoint['host'],$path);
+        }
+        //计算签名，返回包含Authorization的请求头
+        function sign($method,$key,$host,$path,$query,$headers){
+            $config = $this->config[$this->name];
+            $time = time();
+            $date = gmdate('Ymd',$time);
+            $headers['host'] = $host;
+            $headers['x-amz-date'] = gmdate('Ymd\THis\Z',$time);
+            //请求体为文件流，不计算内容的sha256
+            $headers['x-amz-content-sha256'] = 'UNSIGNED-PAYLOAD';
+            ksort($headers);
+            $canonical = '';
+            foreach ($headers as $name => $value) {
+                $canonical .= $name.':'.trim($value)."\n";
+            }
+            $signed = implode(';',array_keys($headers));
+            ksort($query);
+            $params = array();
+            foreach ($query as $name => $value) {
+                $params[] = rawurlencode($name).'='.rawurlencode($value);
+            }
+            $request = $method."\n".$path."\n".implode('&',$params)."\n".$canonical."\n".$signed."\nUNSIGNED-PAYLOAD";
+            $scope = $date.'/'.$config['region'].'/s3/aws4_request';
+            $string = "AWS4-HMAC-SHA256\n".$headers['x-amz-date']."\n".$scope."\n".hash('sha256',$request);
+            $secret = hash_hmac('sha256',$date,'AWS4'.$config['secret'],true);
+            $secret = hash_hmac('sha256',$config['region'],$secret,true);
+            $secret = hash_hmac('sha256','s3',$secret,true);
+            $secret = hash_hmac('sha256','aws4_request',$secret,true);
+            $headers['authorization'] = 'AWS4-HMAC-SHA256 Credential='.$config['key'].'/'.$scope.', SignedHeaders='.$signed.', Signature='.hash_hmac('sha256',$string,$secret);
+            return $headers;
+        }
+        //发送请求，$body为字符串或array(文件句柄,长度)，$sink为下载时写入的文件句柄
+        function request($method,$key,$query = array(),$headers = array(),$body = null,$sink = null){
+            list($scheme,$host,$path) = $this->target($key);
+            $headers = $this->sign($method,$key,$host,$path,$query,$headers);
+            $params = array();
+            foreach ($query as $name => $value) {
+                $params[] = ($value === '') ? $name : $name.'='.rawurlencode($value);
+            }
+            $url = $scheme.'://'.$host.$path.(empty($params) ? '' : '?'.implode('&',$params));
+
+            $header = array('Expect:');
+            foreach ($headers as $name => $value) {
+                $header[] = $name.': '.$value;
+            }
+            $response = array();
+            $curl = curl_init($url);
+            curl_setopt($curl,CURLOPT_CUSTOMREQUEST,$method);
+            curl_setopt($curl,CURLOPT_CONNECTTIMEOUT,10);
+            curl_setopt($curl,CURLOPT_TIMEOUT,600);
+            curl_setopt($curl,CURLOPT_HTTPHEADER,$header);
+            curl_setopt($curl,CURLOPT_HEADERFUNCTION,function($curl,$line) use (&$response) {
+                $pos = strpos($line,':');
+                if($pos !== false) {
+                    $response[strtolower(trim(substr($line,0,$pos)))] = trim(substr($line,$pos + 1));
+                }
+                return strlen($line);
+            });
+            if(is_array($body)) {
+                //从文件句柄的当前位置流式读取指定长度
+                list($handle,$length) = $body;
+                curl_setopt($curl,CURLOPT_UPLOAD,true);
+                curl_setopt($curl,CURLOPT_INFILESIZE,$length);
+                curl_setopt($curl,CURLOPT_READFUNCTION,function($curl,$fd,$size) use ($handle,&$length) {
+                    if($length <= 0) {
+                        return '';
+                    }
+                    $data = fread($handle,min($size,$length));
+                    $length -= strlen($data);
+                    return $data;
+                });
+            }
+            else if(!is_null($body)) {
+                curl_setopt($curl,CURLOPT_POSTFIELDS,$body);
+            }
+            if(!is_null($sink)) {
+                curl_setopt($curl,CURLOPT_FILE,$sink);
+            }
+            else{
+                curl_setopt($curl,CURLOPT_RETURNTRANSFER,true);
+            }
+            if($method == 'HEAD') {
+                curl_setopt($curl,CURLOPT_NOBODY,true);
+            }
+            $result = curl_exec($curl);
+            $status = (int)curl_getinfo($curl,CURLINFO_HTTP_CODE);
+            Pool::metrics($curl);
+            if($result === false) {
+                $this->error = curl_error($curl);
+            }
+            else if($status >= 300) {
+                $this->error = preg_match('/<Message>(.*?)<\/Message>/s',(string)$result,$match) ? $match[1] : 'HTTP '.$status;
+            }
+            curl_close($curl);
+            return array(
+                "status"    =>  $status,
+                "headers"   =>  $response,
+                "body"      =>  is_string($result) ? $result : ''
+            );
+        }
+        //根据扩展名返回Content-Type
+        function mime($key){
+            $types = array(
+                "jpg"   =>  "image/jpeg",
+                "jpeg"  =>  "image/jpeg",
+                "png"   =>  "image/png",
+                "gif"   =>  "image/gif",
+                "bmp"   =>  "image/bmp",
+                "webp"  =>  "image/webp",
+                "avif"  =>  "image/avif"
+            );
+            $ext = strtolower(substr(strrchr($key,'.'),1));
+            return isset($types[$ext]) ? $types[$ext] : 'application/octet-stream';
+        }
+        //上传文件，保留本地文件时同时移动到本地对应位置
+        function put($file,$key){
+            $size = filesize($file);
+            if($size === false) {
+                $this->error = '图片不存在！';
+                return false;
+            }
+            $headers = array(
+                "content-type"  =>  $this->mime($key),
+                //key即内容hash，可以长期缓存
+                "cache-control" =>  "public, max-age=31536000, immutable"
+            );
+            if($size > $this->config['partsize']) {
+                $result = $this->multipart($file,$key,$size,$headers);
+            }
+            else{
+                $handle = fopen($file,'rb');
+                $response = $this->request('PUT',$key,array(),$headers,array($handle,$size));
+                fclose($handle);
+                $result = ($response['status'] == 200);
+            }
+            if($result && ($this->config['keeplocal'] == true)) {
+                return parent::put($file,$key);
+            }
+            return $result;
+        }
+        //分片上传，每个分片直接从文件中流式读取
+        function multipart($file,$key,$size,$headers){
+            $response = $this->request('POST',$key,array("uploads" => ''),$headers,'');
+            if(($response['status'] != 200) || (!preg_match('/<UploadId>(.+?)<\/UploadId>/',$response['body'],$match))) {
+                return false;
+            }
+            $id = $match[1];
+            //除最后一个分片外，每个分片不能小于5M
+            $partsize = max(5242880,(int)$this->config['partsize']);
+            $handle = fopen($file,'rb');
+            $parts = '';
+            for($number = 1,$offset = 0;$offset < $size;$number++,$offset += $partsize) {
+                $length = min($partsize,$size - $offset);
+                fseek($handle,$offset);
+                $response = $this->request('PUT',$key,array("partNumber" => $number,"uploadId" => $id),array(),array($handle,$length));
+                if(($response['status'] != 200) || (!isset($response['headers']['etag']))) {
+                    fclose($handle);
+                    $this->abort($key,$id);
+                    return false;
+                }
+                $parts .= '<Part><PartNumber>'.$number.'</PartNumber><ETag>'.$response['headers']['etag'].'</ETag></Part>';
+            }
+            fclose($handle);
+            $response = $this->request('POST',$key,array("uploadId" => $id),array("content-type" => "application/xml"),'<CompleteMultipartUpload>'.$parts.'</CompleteMultipartUpload>');
+            //合并分片时即使返回200，内容也可能是错误信息
+            if(($response['status'] != 200) || (strpos($response['body'],'<Error>') !== false)) {
+                $this->abort($key,$id);
+                return false;
+            }
+            return true;
+        }
+        //取消分片上传，清理已上传的分片
+        function abort($key,$id){
+            $error = $this->error;
+            $this->request('DELETE',$key,array("uploadId" => $id));
+            $this->error = $error;
+        }
+        //删除对象及本地文件
+        function delete($key){
+            $response = $this->request('DELETE',$key);
+            @unlink(APP.$key);
+            return in_array($response['status'],array(200,204,404));
+        }
+        //本地有文件时不再请求对象存储
+        function exists($key){
+            if(is_file(APP.$key)) {
+                return true;
+            }
+            $response = $this->request('HEAD',$key);
+            if($response['status'] == 200) {
+                return true;
+            }
+            return ($response['status'] == 404) ? false : null;
+        }
+        //本地没有文件时从对象存储下载
+        function fetch($key){
+            $path = APP.$key;
+            if(is_file($path)) {
+                return $path;
+            }
+            if((!is_dir(dirname($path))) && (!@mkdir(dirname($path),0777,true))) {
+                $this->error = '创建目录失败！';
+                return false;
+            }
+            //先下载到临时文件再更名
+            $tmpfile = $path.'.'.uniqid().'.tmp';
+            $sink = fopen($tmpfile,'wb');
+            $response = $this->request('GET',$key,array(),array(),null,$sink);
+            fclose($sink);
+            if(($response['status'] != 200) || (!rename($tmpfile,$path))) {
+                @unlink($tmpfile);
+                return false;
+            }
+            return $path;
+        }
+        //不保留本地文件时删除本地文件
+        function release($key){
+            if($this->config['keeplocal'] != true) {
+                @unlink(APP.$key);
+            }
+            return true;
+        }
+    }
+?>
@@ -0,0 +1,290 @@
+<?php
+    /*
+    MySQL/PostgreSQL数据表结构，与db/imgurl.db3及upgrade.php中SQLite的表结构保持一致
+    所有SQL均可重复执行：表及索引已存在时跳过，触发器删除后重新创建
+    SQLite数据库仍由upgrade.php升级，升级SQL同样通过run()执行
+    */
+    class Schema{
+        var $database;
+        //数据库类型：mysql/pgsql
+        var $type;
+        //run()失败时的SQL及错误信息
+        var $error;
+
+        public function __construct($database){
+            $this->database = $database;
+            $this->type = $database->type();
+        }
+        /*
+        数据表定义，字段类型：
+        pk 自增主键，string 可建立索引的短文本（MySQL为VARCHAR(255)），text 长文本，int/bigint 整数，real 浮点数
+        */
+        function tables(){
+            return array(
+                "imginfo"   =>  array(
+                    "columns"   =>  array(
+                        "id"        =>  "pk",
+                        "path"      =>  "string NOT NULL",
+                        "ip"        =>  "string NOT NULL",
+                        "ua"        =>  "text NOT NULL",
+                        "date"      =>  "string NOT NULL",
+                        "dir"       =>  "string NOT NULL",
+                        "compress"  =>  "int",
+                        "level"     =>  "int",
+                        "hash"      =>  "string",
+                        "day"       =>  "int",
+                        "saved"     =>  "bigint",
+                        "size"      =>  "bigint",
+                        "csize"     =>  "bigint",
+                        "width"     =>  "int",
+                        "height"    =>  "int",
+                        "mime"      =>  "string",
+                        "phash"     =>  "string",
+                        "ph1"       =>  "int",
+                        "ph2"       =>  "int",
+                        "ph3"       =>  "int",
+                        "ph4"       =>  "int",
+                        "make"      =>  "string",
+                        "model"     =>  "string",
+                        "taken"     =>  "string",
+                        "lat"       =>  "real",
+                        "lng"       =>  "real"
+                    )
+                ),
+                "sm"        =>  array(
+                    "columns"   =>  array(
+                        "id"        =>  "pk",
+                        "ip"        =>  "string NOT NULL",
+                        "ua"        =>  "text NOT NULL",
+                        "date"      =>  "string NOT NULL",
+                        "url"       =>  "text NOT NULL",
+                        "delete"    =>  "string NOT NULL",
+                        "imgid"     =>  "bigint"
+                    )
+                ),
+                "tinykey"   =>  array(
+                    "columns"   =>  array(
+                        "key"       =>  "string NOT NULL",
+                        "month"     =>  "int NOT NULL",
+                        "count"     =>  "int NOT NULL DEFAULT 0"
+                    ),
+                    "primary"   =>  array("key")
+                ),
+                "queue"     =>  array(
+                    "columns"   =>  array(
+                        "id"        =>  "pk",
+                        "type"      =>  "string NOT NULL",
+                        "target"    =>  "bigint NOT NULL",
+                        "data"      =>  "text",
+                        "status"    =>  "int NOT NULL DEFAULT 0",
+                        "attempts"  =>  "int NOT NULL DEFAULT 0",
+                        "runat"     =>  "bigint NOT NULL",
+                        "lease"     =>  "bigint NOT NULL DEFAULT 0",
+                        "owner"     =>  "string",
+                        "error"     =>  "text",
+                        "created"   =>  "bigint NOT NULL"
+                    )
+                ),
+                "limiter"   =>  array(
+                    "columns"   =>  array(
+                        "key"       =>  "string NOT NULL",
+                        "tokens"    =>  "real NOT NULL",
+                        "updated"   =>  "bigint NOT NULL"
+                    ),
+                    "primary"   =>  array("key")
+                ),
+                "stats"     =>  array(
+                    "columns"   =>  array(
+                        "day"       =>  "int NOT NULL",
+                        "dir"       =>  "string NOT NULL",
+                        "level"     =>  "int NOT NULL",
+                        "num"       =>  "bigint NOT NULL DEFAULT 0",
+                        "bytes"     =>  "bigint NOT NULL DEFAULT 0"
+                    ),
+                    "primary"   =>  array("day","dir","level")
+                )
+            );
+        }
+        //索引，名称 => array(表,字段,是否唯一)，用途见upgrade.php
+        function indexes(){
+            return array(
+                "imginfo_hash"  =>  array("imginfo",array("hash"),false),
+                "imginfo_path"  =>  array("imginfo",array("path"),true),
+                "imginfo_limit" =>  array("imginfo",array("ip","day","dir"),false),
+                "imginfo_dir"   =>  array("imginfo",array("dir","id"),false),
+                "imginfo_level" =>  array("imginfo",array("level","id"),false),
+                "imginfo_day"   =>  array("imginfo",array("day"),false),
+                "imginfo_found" =>  array("imginfo",array("dir","day","level","path"),false),
+                "imginfo_ph1"   =>  array("imginfo",array("ph1"),false),
+                "imginfo_ph2"   =>  array("imginfo",array("ph2"),false),
+                "imginfo_ph3"   =>  array("imginfo",array("ph3"),false),
+                "imginfo_ph4"   =>  array("imginfo",array("ph4"),false),
+                "sm_delete"     =>  array("sm",array("delete"),true),
+                "sm_imgid"      =>  array("sm",array("imgid"),false),
+                "queue_job"     =>  array("queue",array("type","target"),true),
+                "queue_claim"   =>  array("queue",array("status","runat"),false),
+                "queue_owner"   =>  array("queue",array("owner"),false)
+            );
+        }
+        //字段类型转换为对应数据库的类型
+        function column($type){
+            if($type == 'pk') {
+                return ($this->type == 'mysql') ? 'BIGINT NOT NULL AUTO_INCREMENT PRIMARY KEY' : 'BIGSERIAL PRIMARY KEY';
+            }
+            $types = ($this->type == 'mysql') ? array(
+                "string"    =>  "VARCHAR(255)",
+                "text"      =>  "TEXT",
+                "bigint"    =>  "BIGINT",
+                "int"       =>  "INT",
+                "real"      =>  "DOUBLE"
+            ) : array(
+                "string"    =>  "TEXT",
+                "text"      =>  "TEXT",
+                "bigint"    =>  "BIGINT",
+                "int"       =>  "INTEGER",
+                "real"      =>  "DOUBLE PRECISION"
+            );
+            list($name,$rest) = array_pad(explode(' ',$type,2),2,'');
+            return trim($types[$name].' '.$rest);
+        }
+        //字段列表加引号："a","b"
+        function quote($columns){
+            return '"'.implode('","',$columns).'"';
+        }
+        //建表语句
+        function create($table,$define){
+            $items = array();
+            foreach ($define['columns'] as $name => $type) {
+                $items[] = '"'.$name.'" '.$this->column($type);
+            }
+            if(isset($define['primary'])) {
+                $items[] = 'PRIMARY KEY ('.$this->quote($define['primary']).')';
+            }
+            $sql = 'CREATE TABLE IF NOT EXISTS "'.$table.'" ('."\n".implode(",\n",$items)."\n".')';
+            if($this->type == 'mysql') {
+                $sql .= ' ENGINE=InnoDB DEFAULT CHARSET=utf8mb4';
+            }
+            return $sql;
+        }
+        //判断表是否存在
+        function hastable($table){
+            return $this->database->query('SELECT COUNT(*) FROM information_schema.tables WHERE table_schema = '.$this->schema().' AND table_name = :table',[
+                ":table"    =>  $table
+            ])->fetchColumn() > 0;
+        }
+        //判断字段是否存在
+        function hascolumn($table,$column){
+            return $this->database->query('SELECT COUNT(*) FROM information_schema.columns WHERE table_schema = '.$this->schema().' AND table_name = :table AND column_name = :column',[
+                ":table"    =>  $table,
+                ":column"   =>  $column
+            ])->fetchColumn() > 0;
+        }
+        //判断索引是否存在，MySQL不支持CREATE INDEX IF NOT EXISTS
+        function hasindex($table,$name){
+            return $this->database->query('SELECT COUNT(*) FROM information_schema.statistics WHERE table_schema = DATABASE() AND table_name = :table AND index_name = :name',[
+                ":table"    =>  $table,
+                ":name"     =>  $name
+            ])->fetchColumn() > 0;
+        }
+        //当前数据库（MySQL）或模式（PostgreSQL）
+        function schema(){
+            return ($this->type == 'mysql') ? 'DATABASE()' : 'current_schema()';
+        }
+        //统计表触发器，与SQLite的stats_insert/stats_delete/stats_update作用相同
+        function triggers(){
+            $sqls = array();
+            if($this->type == 'mysql') {
+                $insert = 'INSERT INTO "stats" ("day","dir","level","num","bytes") VALUES (IFNULL(NEW."day",0),NEW."dir",IFNULL(NEW."level",0),1,IFNULL(NEW."csize",0)) ON DUPLICATE KEY UPDATE "num" = "num" + 1, "bytes" = "bytes" + IFNULL(NEW."csize",0)';
+                $delete = 'UPDATE "stats" SET "num" = "num" - 1, "bytes" = "bytes" - IFNULL(OLD."csize",0) WHERE "day" = IFNULL(OLD."day",0) AND "dir" = OLD."dir" AND "level" = IFNULL(OLD."level",0)';
+                foreach (array("stats_insert","stats_delete","stats_update") as $name) {
+                    $sqls[] = 'DROP TRIGGER IF EXISTS "'.$name.'"';
+                }
+                $sqls[] = 'CREATE TRIGGER "stats_insert" AFTER INSERT ON "imginfo" FOR EACH ROW '.$insert;
+                $sqls[] = 'CREATE TRIGGER "stats_delete" AFTER DELETE ON "imginfo" FOR EACH ROW '.$delete;
+                //MySQL的触发器不能指定字段，只在统计相关的字段变化时更新
+                $sqls[] = 'CREATE TRIGGER "stats_update" AFTER UPDATE ON "imginfo" FOR EACH ROW BEGIN
+IF NOT (NEW."day" <=> OLD."day" AND NEW."dir" <=> OLD."dir" AND NEW."level" <=> OLD."level" AND NEW."csize" <=> OLD."csize") THEN
+'.$delete.';
+'.$insert.';
+END IF;
+END';
+            }
+            else{
+                $sqls[] = 'CREATE OR REPLACE FUNCTION "stats_sync"() RETURNS TRIGGER AS $$
+BEGIN
+IF TG_OP IN (\'DELETE\',\'UPDATE\') THEN
+UPDATE "stats" SET "num" = "num" - 1, "bytes" = "bytes" - COALESCE(OLD."csize",0) WHERE "day" = COALESCE(OLD."day",0) AND "dir" = OLD."dir" AND "level" = COALESCE(OLD."level",0);
+END IF;
+IF TG_OP IN (\'INSERT\',\'UPDATE\') THEN
+INSERT INTO "stats" ("day","dir","level","num","bytes") VALUES (COALESCE(NEW."day",0),NEW."dir",COALESCE(NEW."level",0),1,COALESCE(NEW."csize",0)) ON CONFLICT ("day","dir","level") DO UPDATE SET "num" = "stats"."num" + 1, "bytes" = "stats"."bytes" + EXCLUDED."bytes";
+END IF;
+RETURN NULL;
+END;
+$$ LANGUAGE plpgsql';
+                foreach (array("stats_insert","stats_delete","stats_update") as $name) {
+                    $sqls[] = 'DROP TRIGGER IF EXISTS "'.$name.'" ON "imginfo"';
+                }
+                $sqls[] = 'CREATE TRIGGER "stats_insert" AFTER INSERT ON "imginfo" FOR EACH ROW EXECUTE PROCEDURE "stats_sync"()';
+                $sqls[] = 'CREATE TRIGGER "stats_delete" AFTER DELETE ON "imginfo" FOR EACH ROW EXECUTE PROCEDURE "stats_sync"()';
+                $sqls[] = 'CREATE TRIGGER "stats_update" AFTER UPDATE OF "day","dir","level","csize" ON "imginfo" FOR EACH ROW EXECUTE PROCEDURE "stats_sync"()';
+            }
+            return $sqls;
+        }
+        //根据现有数据重新生成统计
+        function rebuild(){
+            return array(
+                'DELETE FROM "stats"',
+                'INSERT INTO "stats" ("day","dir","level","num","bytes") SELECT COALESCE("day",0),"dir",COALESCE("level",0),COUNT(*),SUM(COALESCE("csize",0)) FROM "imginfo" GROUP BY COALESCE("day",0),"dir",COALESCE("level",0)'
+            );
+        }
+        //建立或升级表结构需要执行的全部SQL
+        function sqls(){
+            $sqls = array();
+            foreach ($this->tables() as $table => $define) {
+                if(!$this->hastable($table)) {
+                    $sqls[] = $this->create($table,$define);
+                    continue;
+                }
+                //表已存在时补充后来增加的字段
+                foreach ($define['columns'] as $name => $type) {
+                    if(($type != 'pk') && (!$this->hascolumn($table,$name))) {
+                        $sqls[] = 'ALTER TABLE "'.$table.'" ADD COLUMN "'.$name.'" '.str_replace(' NOT NULL','',$this->column($type));
+                    }
+                }
+            }
+            foreach ($this->indexes() as $name => $index) {
+                list($table,$columns,$unique) = $index;
+                $sql = 'CREATE '.($unique ? 'UNIQUE ' : '').'INDEX ';
+                if($this->type == 'mysql') {
+                    if($this->hasindex($table,$name)) {
+                        continue;
+                    }
+                    $sqls[] = $sql.'"'.$name.'" ON "'.$table.'" ('.$this->quote($columns).')';
+                }
+                else{
+                    $sqls[] = $sql.'IF NOT EXISTS "'.$name.'" ON "'.$table.'" ('.$this->quote($columns).')';
+                }
+            }
+            return array_merge($sqls,$this->triggers());
+        }
+        /*
+        依次执行SQL，任何一条失败即停止，成功返回true，失败返回false并设置$this->error
+        Medoo的query()在执行失败时仍然返回statement（MySQL默认模拟预处理），需要检查错误码
+        */
+        function run($sqls){
+            foreach ($sqls as $sql) {
+                $statement = $this->database->query($sql);
+                $error = $statement ? $statement->errorInfo() : $this->database->pdo->errorInfo();
+                if($error[0] !== '00000') {
+                    $this->error = $error[2]."\n".$sql;
+                    return false;
+                }
+            }
+            return true;
+        }
+        //更新查询计划统计信息
+        function analyze(){
+            return ($this->type == 'mysql') ? 'ANALYZE TABLE "imginfo","sm","queue","stats"' : 'ANALYZE';
+        }
+    }
+?>
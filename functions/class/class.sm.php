@@ -0,0 +1,106 @@
+<?php
+    /*
+    SM.MS及其它远程图床镜像，上传与删除都通过Pool并发处理
+    镜像结果写入sm表，imgid为对应的本站图片ID
+    */
+    class Sm{
+        var $config;
+        var $database;
+        var $pool;
+
+        //构造函数，$config为配置文件中的$mirror
+        public function __construct($config,$database){
+            $this->config = $config;
+            $this->database = $database;
+            $this->pool = new Pool($config);
+        }
+        //按data.url形式的路径读取接口返回的值
+        function value($data,$key){
+            foreach (explode('.',$key) as $name) {
+                if((!is_array($data)) || (!isset($data[$name]))) {
+                    return '';
+                }
+                $data = $data[$name];
+            }
+            return is_string($data) ? $data : '';
+        }
+        //接口返回的错误信息
+        function message($result){
+            if($result['error'] != '') {
+                return $result['error'];
+            }
+            $data = json_decode($result['body'],true);
+            if(is_array($data) && isset($data['message'])) {
+                return $data['message'];
+            }
+            if(is_array($data) && isset($data['msg'])) {
+                return $data['msg'];
+            }
+            return 'HTTP '.$result['status'];
+        }
+        /*
+        批量上传，$images为 key => array(id,file)，file为本地文件路径
+        成功的图片在一个事务中写入sm表，返回 key => true 或错误信息
+        */
+        function upload($images,$ip = '127.0.0.1',$ua = 'ImgURL'){
+            $requests = array();
+            foreach ($images as $key => $img) {
+                $headers = array('Expect:');
+                if($this->config['token'] != '') {
+                    $headers[] = 'Authorization: '.$this->config['token'];
+                }
+                $requests[$key] = array(
+                    CURLOPT_URL         =>  $this->config['api'],
+                    CURLOPT_POST        =>  true,
+                    CURLOPT_HTTPHEADER  =>  $headers,
+                    CURLOPT_POSTFIELDS  =>  array($this->config['field'] => new CURLFile($img['file']))
+                );
+            }
+            $results = $this->pool->run($requests);
+
+            $done = array();
+            $rows = array();
+            foreach ($results as $key => $result) {
+                $data = json_decode($result['body'],true);
+                $url = $this->value($data,$this->config['url']);
+                $delete = $this->value($data,$this->config['delete']);
+                if(($result['status'] != 200) || (!filter_var($url,FILTER_VALIDATE_URL)) || (!filter_var($delete,FILTER_VALIDATE_URL))) {
+                    $done[$key] = $this->message($result);
+                    continue;
+                }
+                $done[$key] = true;
+                $rows[] = array(
+                    "ip"        =>  $ip,
+                    "ua"        =>  $ua,
+                    "date"      =>  date('Y-m-d',time()),
+                    "url"       =>  $url,
+                    "delete"    =>  $delete,
+                    "imgid"     =>  $images[$key]['id']
+                );
+            }
+            if(!empty($rows)) {
+                $this->database->action(function($database) use ($rows) {
+                    foreach ($rows as $row) {
+                        $database->insert("sm",$row);
+                    }
+                });
+            }
+            return $done;
+        }
+        //批量删除，$links为 key => 删除链接，返回 key => true 或错误信息
+        function delete($links){
+            $requests = array();
+            foreach ($links as $key => $link) {
+                $requests[$key] = array(
+                    CURLOPT_URL     =>  $link
+                );
+            }
+            $done = array();
+            foreach ($this->pool->run($requests) as $key => $result) {
+                //图片已经不存在同样视为删除成功
+                $done[$key] = (($result['error'] == '') && (($result['status'] < 400) || ($result['status'] == 404))) ? true : $this->message($result);
+            }
+            return $done;
+        }
+    }
+?>
@@ -0,0 +1,77 @@
+<?php
+    /*
+    图片存储，默认为本地磁盘，S3Storage/OssStorage为对象存储
+    图片按内容hash分目录存放：目录/ab/cd/完整hash.扩展名，存储的key与imginfo中的path相同
+    */
+    class Storage{
+        var $config;
+        //站点地址，未设置访问地址时使用
+        var $domain;
+        //失败原因
+        var $error;
+
+        //根据配置创建对应的存储，$config为配置文件中的$storage
+        static function create($config,$domain){
+            switch ($config['driver']) {
+                case 's3':
+                    return new S3Storage($config,$domain);
+                case 'oss':
+                    return new OssStorage($config,$domain);
+                default:
+                    return new Storage($config,$domain);
+            }
+        }
+        public function __construct($config,$domain){
+            $this->config = $config;
+            $this->domain = $domain;
+        }
+        //按hash前4位分两级目录：temp/ab/cd
+        function dir($dir,$hash){
+            return $dir.'/'.substr($hash,0,2).'/'.substr($hash,2,2);
+        }
+        //图片key：temp/ab/cd/abcd....jpg
+        function key($dir,$hash,$ext){
+            return $this->dir($dir,$hash).'/'.$hash.'.'.$ext;
+        }
+        //是否为对象存储
+        function remote(){
+            return false;
+        }
+        //图片访问地址
+        function url($key){
+            return (($this->config['url'] != '') ? $this->config['url'] : $this->domain).$key;
+        }
+        //保存本地文件，本地存储时移动到对应位置
+        function put($file,$key){
+            $path = APP.$key;
+            if($file == $path) {
+                return true;
+            }
+            if((!is_dir(dirname($path))) && (!@mkdir(dirname($path),0777,true))) {
+                $this->error = '创建目录失败！';
+                return false;
+            }
+            if(!rename($file,$path)) {
+                $this->error = '保存图片失败！';
+                return false;
+            }
+            return true;
+        }
+        //删除图片
+        function delete($key){
+            return @unlink(APP.$key);
+        }
+        //图片是否存在，无法确定时（如网络错误）返回null
+        function exists($key){
+            return is_file(APP.$key);
+        }
+        //返回图片的本地路径，对象存储在本地没有文件时下载，失败返回false
+        function fetch($key){
+            return is_file(APP.$key) ? APP.$key : false;
+        }
+        //处理完成后释放本地文件，只有对象存储且不保留本地文件时才会删除
+        function release($key){
+            return true;
+        }
+    }
+?>
@@ -0,0 +1,19 @@
+<?php
+    /*
+    带耗时统计的Medoo，所有查询最终都经过exec()执行，在此处按语句类型及表名计时
+    */
+    class Timedmedoo extends Medoo\Medoo{
+        //Metrics对象，由Db在连接后设置
+        public $metrics;
+
+        public function exec($query, $map = []){
+            $start = $this->metrics->now();
+            $statement = parent::exec($query,$map);
+            //语句类型：SELECT/INSERT/UPDATE/DELETE/PRAGMA...，表名取第一个FROM/INTO/UPDATE后的表
+            $op = strtolower(strtok(ltrim($query),' '));
+            $table = preg_match('/(FROM|INTO|UPDATE)\s+"([a-zA-Z0-9_]+)"/i',$query,$match) ? $match[2] : '';
+            $this->metrics->stop('db',$start,0,array("op" => $op,"table" => $table));
+            return $statement;
+        }
+    }
+?>
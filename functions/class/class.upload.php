@@ -678,6 +678,20 @@ class upload {
      */
     var $image_max_pixels;
 
+    /**
+     * Set this variable to set a maximum amount of memory GD may use to decode the image, above which the processing is refused
+     *
+     * The memory needed is estimated from the image dimensions, before the image is decoded.
+     * The limit is also capped by what remains of PHP's memory_limit; use 'auto' to only check memory_limit.
+     * Files which are only copied, without any image manipulation, are not checked
+     *
+     * Value is in bytes, or shorthand byte options (512K, 64M). Default value is null
+     *
+     * @access public
+     * @var mixed
+     */
+    var $image_max_memory;
+
     /**
      * Set this variable to set a maximum image aspect ratio, above which the upload will be invalid
      *
@@ -1761,6 +1775,7 @@ class upload {
         $this->image_max_width          = null;
         $this->image_max_height         = null;
         $this->image_max_pixels         = null;
+        $this->image_max_memory         = null;
         $this->image_max_ratio          = null;
         $this->image_min_width          = null;
         $this->image_min_height         = null;
@@ -2101,6 +2116,7 @@ class upload {
         $this->translation['ratio_too_low']               = 'Image ratio too low (image too high).';
         $this->translation['too_many_pixels']             = 'Image has too many pixels.';
         $this->translation['not_enough_pixels']           = 'Image has not enough pixels.';
+        $this->translation['not_enough_memory']           = 'Image is too large to be processed in memory.';
         $this->translation['file_not_uploaded']           = 'File not uploaded. Can\'t carry on a process.';
         $this->translation['already_exists']              = '%s already exists. Please change the file name.';
         $this->translation['temp_file_missing']           = 'No correct temp source file. Can\'t carry on a process.';
@@ -2774,7 +2790,7 @@ class upload {
      */
     function getsize($size) {
         if ($size === null) return null;
-        $last = strtolower($size{strlen($size)-1});
+        $last = strtolower(substr($size, -1));
         $size = (int) $size;
         switch($last) {
             case 'g':
@@ -2787,6 +2803,23 @@ class upload {
         return $size;
     }
 
+    /**
+     * Returns the memory available to decode an image
+     *
+     * @access private
+     * @param  mixed   $limit  Limit in bytes, shorthand byte options, or 'auto'
+     * @return integer Available memory in bytes, or null if unlimited
+     */
+    function memoryavailable($limit) {
+        $available = ($limit === 'auto') ? null : $this->getsize($limit);
+        $memory_limit = $this->getsize(ini_get('memory_limit'));
+        if ($memory_limit > 0) {
+            $headroom = $memory_limit - memory_get_usage();
+            $available = is_null($available) ? $headroom : min($available, $headroom);
+        }
+        return $available;
+    }
+
     /**
      * Decodes offsets
      *
@@ -3317,10 +3350,19 @@ class upload {
             // check if we need to autorotate, to automatically pre-rotates the image according to EXIF data (JPEG only)
             $auto_flip = false;
             $auto_rotate = 0;
-            if ($this->file_is_image && $this->image_auto_rotate && $this->image_src_type == 'jpg' && $this->function_enabled('exif_read_data')) {
-                $exif = @exif_read_data($this->file_src_pathname);
-                if (is_array($exif) && isset($exif['Orientation'])) {
-                    $orientation = $exif['Orientation'];
+            if ($this->file_is_image && $this->image_auto_rotate && $this->image_src_type == 'jpg' && (class_exists('Exif') || $this->function_enabled('exif_read_data'))) {
+                // read the orientation from the JPEG header with the Exif class when available, so the exif extension is not required
+                $orientation = 0;
+                if (class_exists('Exif')) {
+                    $exif = new Exif();
+                    $orientation = $exif->orientation($this->file_src_pathname);
+                } else {
+                    $exif = @exif_read_data($this->file_src_pathname);
+                    if (is_array($exif) && isset($exif['Orientation'])) {
+                        $orientation = $exif['Orientation'];
+                    }
+                }
+                if ($orientation > 0) {
                     switch($orientation) {
                       case 1:
                         $this->log .= '- EXIF orientation = 1 : default<br />';
@@ -3373,7 +3415,7 @@ class upload {
             }
 
             // do we do some image manipulation?
-            $image_manipulation  = ($this->file_is_image && (
+            $image_transform     = ($this->file_is_image && (
                                     $this->image_resize
                                  || $this->image_convert != ''
                                  || is_numeric($this->image_brightness)
@@ -3388,7 +3430,6 @@ class upload {
                                  || $this->image_greyscale
                                  || $this->image_negative
                                  || !empty($this->image_watermark)
-                                 || $auto_rotate || $auto_flip
                                  || is_numeric($this->image_rotate)
                                  || is_numeric($this->jpeg_size)
                                  || !empty($this->image_flip)
@@ -3399,6 +3440,7 @@ class upload {
                                  || $this->image_frame > 0
                                  || $this->image_bevel > 0
                                  || $this->image_reflection_height));
+            $image_manipulation  = ($image_transform || ($this->file_is_image && ($auto_rotate || $auto_flip)));
 
             // we do a quick check to ensure the file is really an image
             // we can do this only now, as it would have failed before in case of open_basedir
@@ -3407,6 +3449,24 @@ class upload {
                 $image_manipulation = false;
             }
 
+            // we check that the decoded image will fit in memory, before GD decodes it
+            // a truecolor GD image takes about 5 bytes per pixel, and we need the source and the destination images
+            if ($image_manipulation && !is_null($this->image_max_memory) && is_numeric($this->image_src_pixels)) {
+                $memory_needed = $this->image_src_pixels * 5 * 2;
+                $memory_available = $this->memoryavailable($this->image_max_memory);
+                if (!is_null($memory_available) && $memory_needed > $memory_available) {
+                    if ($image_transform) {
+                        $this->processed = false;
+                        $this->error = $this->translate('not_enough_memory');
+                        $this->log .= '- not enough memory to decode the image : ' . $memory_needed . ' bytes needed<br />';
+                    } else {
+                        // only the EXIF auto-rotation needed a decode, we keep the file as it is
+                        $this->log .= '- not enough memory to auto-rotate, the image is copied as it is<br />';
+                    }
+                    $image_manipulation = false;
+                }
+            }
+
             if ($image_manipulation) {
 
                 // make sure GD doesn't complain too much
@@ -4876,7 +4936,7 @@ class upload {
                     }
                 }
 
-            } else {
+            } else if ($this->processed) {
                 $this->log .= '- no image processing wanted<br />';
 
                 if (!$return_mode) {
@@ -0,0 +1,335 @@
+<?php
+    /*
+    图片上传处理，单张上传与批量上传共用
+    process()逐张处理图片，insert()在一个事务中写入全部新图片
+    */
+    class Uploader{
+        var $config;
+        var $database;
+        var $optimize;
+        var $queue;
+        //EXIF处理设置
+        var $exif;
+        //图片存储
+        var $store;
+        //失败原因
+        var $error;
+        //单张图片最大大小（字节）
+        var $maxsize = 2097152;
+        //宽或高超过此值的图片按比例缩小后保存，0为不缩小
+        var $maxwidth = 0;
+
+        //构造函数，$optimize、$queue、$storage、$exif为配置文件中的同名数组
+        public function __construct($config,$database,$optimize,$queue,$storage,$exif = null){
+            $this->config = $config;
+            $this->database = $database;
+            $this->optimize = $optimize;
+            $this->queue = $queue;
+            $this->exif = is_null($exif) ? array("strip" => false,"save" => false) : $exif;
+            $this->store = Storage::create($storage,$config['domain']);
+        }
+        //文件hash算法，不支持xxh128时使用sha256
+        static function algo($config){
+            $algo = ($config['hash'] == '') ? 'auto' : $config['hash'];
+            if(($algo == 'auto') || (!in_array($algo,hash_algos()))) {
+                $algo = in_array('xxh128',hash_algos()) ? 'xxh128' : 'sha256';
+            }
+            return $algo;
+        }
+        //hash相同时确认内容确实相同：原图大小一致，已保存的文件未经处理（大小相同）时再逐字节比较
+        function same($info,$file){
+            $size = filesize($file);
+            if((!is_null($info['size'])) && ((int)$info['size'] != $size)) {
+                return false;
+            }
+            $path = APP.$info['path'];
+            if(is_file($path) && (filesize($path) == $size)) {
+                $a = fopen($path,'rb');
+                $b = fopen($file,'rb');
+                $same = true;
+                while($same && (!feof($a))) {
+                    $same = (fread($a,1048576) === fread($b,1048576));
+                }
+                fclose($a);
+                fclose($b);
+                return $same;
+            }
+            //大小一致且无法比较文件内容（已压缩或不在本地）时，以完整hash为准
+            return !is_null($info['size']);
+        }
+        //文件名：完整hash，与已有图片hash冲突时加上后缀（hash-1、hash-2）
+        function name($hash,$datas){
+            if(empty($datas)) {
+                return $hash;
+            }
+            $suffix = 0;
+            foreach ($datas as $info) {
+                $name = pathinfo($info['path'],PATHINFO_FILENAME);
+                if(preg_match('/-(\d+)$/',$name,$match)) {
+                    $suffix = max($suffix,(int)$match[1]);
+                }
+            }
+            return $hash.'-'.($suffix + 1);
+        }
+        //返回给前端的图片信息
+        function result($info){
+            return array(
+                "code"      =>  1,
+                "id"        =>  $info['id'],
+                "url"       =>  $this->store->url($info['path']),
+                "width"     =>  (int)$info['width'],
+                "height"    =>  (int)$info['height']
+            );
+        }
+        //处理一张图片，$file为$_FILES中的单个文件，或分片上传完成后的本地文件路径及其$hash
+        //已上传过的图片直接返回已有信息，新图片返回的数据中row为待写入数据库的内容，失败返回false
+        function process($file,$updir,$ip,$ua,$hash = ''){
+            global $metrics;
+            $this->error = '';
+            //上传前直接对PHP临时文件计算hash，已经上传过的图片不再进入上传类处理
+            if(($hash == '') && is_array($file) && is_uploaded_file($file['tmp_name'])) {
+                $hash = hash_file(self::algo($this->config),$file['tmp_name'],FALSE);
+            }
+            $name = $hash;
+            if($hash != '') {
+                //hash冲突时同一hash会有多张图片，逐个确认内容
+                $datas = $this->database->select("imginfo",["id","path","width","height","size"],[
+                    "hash"  =>  $hash,
+                    "dir"   =>  $updir
+                ]);
+                foreach ($datas as $info) {
+                    if($this->same($info,is_array($file) ? $file['tmp_name'] : $file)) {
+                        if(!is_array($file)) {
+                            @unlink($file);
+                        }
+                        return $this->result($info);
+                    }
+                }
+                $name = $this->name($hash,$datas);
+            }
+
+            //上传类在此处自动载入
+            $handle = new upload($file);
+            if((!$handle->uploaded) || ($hash == '')) {
+                $this->error = $handle->uploaded ? '读取上传文件失败！' : $handle->error;
+                return false;
+            }
+            //以完整的文件hash作为文件名，处理完成后无需再更名
+            $handle->file_new_name_body = $name;
+            $handle->file_overwrite = true;
+            //允许上传大小，默认2m
+            $handle->file_max_size = $this->maxsize;
+            //允许的MIME类型，仅运行上传图片
+            $handle->allowed = array('image/*');
+            //在解码前根据图片尺寸检查像素数量，并估算解码所需内存，超过memory_limit剩余内存时拒绝处理
+            $handle->image_max_pixels = $this->config['maxpixels'];
+            $handle->image_max_memory = 'auto';
+            //尺寸过大的图片按比例缩小，只读取文件头判断尺寸，不超过时不解码图片
+            if($this->maxwidth > 0) {
+                $info = @getimagesize($handle->file_src_pathname);
+                if($info && (max($info[0],$info[1]) > $this->maxwidth)) {
+                    $handle->image_resize = true;
+                    $handle->image_x = $this->maxwidth;
+                    $handle->image_y = $this->maxwidth;
+                    $handle->image_ratio = true;
+                }
+            }
+            //JPEG只读取一次文件头，得到方向及拍摄信息
+            $reader = new Exif();
+            $meta = false;
+            if($handle->file_src_mime == 'image/jpeg') {
+                $start = $metrics->now();
+                $meta = $reader->read($handle->file_src_pathname);
+                $metrics->stop('image',$start,0,array("op" => "exif"));
+            }
+            //不需要缩小的JPEG不再由上传类解码旋转，原样保存后直接修改文件头；需要缩小时反正要重新编码，由上传类一并旋转
+            $lossless = ($meta !== false) && (!$handle->image_resize);
+            if($lossless) {
+                $handle->image_auto_rotate = false;
+            }
+            //开启本地优化时，需要重新编码的图片（如自动旋转）同样使用渐进式及指定质量
+            if($this->optimize['option'] == true) {
+                $handle->jpeg_quality = $this->optimize['quality'];
+                $handle->image_interlace = true;
+            }
+
+            //上传路径：目录 + hash前4位分两级目录，避免单个目录下文件过多
+            $dstdir = $this->store->dir($updir,$hash);
+            $start = $metrics->now();
+            $handle->process(APP.$dstdir."/");
+            $metrics->stop('image',$start,(int)$handle->file_src_size,array("op" => "upload"));
+            if(!$handle->processed) {
+                $this->error = $handle->error;
+                return false;
+            }
+            //图片路径(temp/d6/4c/d64c8036c0605175....jpg)
+            $imgdir = $dstdir.'/'.$handle->file_dst_name;
+            //宽高为显示时的尺寸，方向为5-8的图片显示时宽高互换
+            $width = $handle->image_dst_x;
+            $height = $handle->image_dst_y;
+            if($lossless) {
+                if($this->exif['strip'] == true) {
+                    $start = $metrics->now();
+                    $reader->strip($handle->file_dst_pathname,$meta['orientation']);
+                    $metrics->stop('image',$start,0,array("op" => "strip"));
+                }
+                if($meta['orientation'] >= 5) {
+                    list($width,$height) = array($height,$width);
+                }
+            }
+
+            //本地图片优化，优化过的图片不再使用TinyPNG压缩
+            $compress = 0;
+            $saved = 0;
+            if($this->optimize['option'] == true) {
+                $optimizer = new Optimizer($this->optimize);
+                //开启后台队列时WebP/AVIF由functions/worker.php生成
+                $start = $metrics->now();
+                $optimized = $optimizer->run($handle->file_dst_pathname,$this->queue['option'] != true);
+                $metrics->stop('image',$start,filesize($handle->file_dst_pathname),array("op" => "optimize"));
+                if($optimized !== false) {
+                    $compress = 1;
+                    $saved = $optimized['saved'];
+                }
+            }
+
+            //感知hash，鉴黄时复用相似图片的结果
+            $phash = new Phash();
+            $start = $metrics->now();
+            $ph = $phash->file($handle->file_dst_pathname);
+            $metrics->stop('image',$start,0,array("op" => "phash"));
+            $bands = ($ph === false) ? array("ph1" => null,"ph2" => null,"ph3" => null,"ph4" => null) : $phash->bands($ph);
+
+            //本地存储时文件已在对应位置，对象存储时上传原图及WebP/AVIF
+            $csize = filesize($handle->file_dst_pathname);
+            $keys = array($imgdir);
+            foreach (array('webp','avif') as $format) {
+                if(is_file($handle->file_dst_pathname.'.'.$format)) {
+                    $keys[] = $imgdir.'.'.$format;
+                }
+            }
+            //WebP/AVIF由后台队列生成时暂不释放本地文件，由functions/worker.php生成后释放
+            $defer = ($this->optimize['option'] == true) && ($this->queue['option'] == true);
+            foreach ($keys as $key) {
+                if(!$this->store->put(APP.$key,$key)) {
+                    $this->error = $this->store->error;
+                    foreach ($keys as $key) {
+                        @unlink(APP.$key);
+                    }
+                    $handle->clean();
+                    return false;
+                }
+                if(!$defer) {
+                    $this->store->release($key);
+                }
+            }
+
+            $redata = array(
+                "code"      =>  1,
+                "id"        =>  0,
+                "url"       =>  $this->store->url($imgdir),
+                "width"     =>  $width,
+                "height"    =>  $height,
+                "saved"     =>  $saved,
+                "row"       =>  array(
+                    "path"      =>  $imgdir,
+                    "hash"      =>  $hash,
+                    "ip"        =>  $ip,
+                    "ua"        =>  $ua,
+                    "date"      =>  date('Y-m-d',time()),
+                    "day"       =>  (int)date('Ymd',time()),
+                    "dir"       =>  $updir,
+                    "compress"  =>  $compress,
+                    "saved"     =>  $saved,
+                    "level"     =>  0,
+                    "size"      =>  $handle->file_src_size,
+                    "csize"     =>  $csize,
+                    "width"     =>  $width,
+                    "height"    =>  $height,
+                    "mime"      =>  $handle->file_src_mime,
+                    "phash"     =>  ($ph === false) ? null : $ph
+                ) + $bands
+            );
+            //拍摄设备、时间及GPS坐标，在去除元数据前已经读取
+            if($this->exif['save'] == true) {
+                foreach (array("make","model","taken","lat","lng") as $key) {
+                    $redata['row'][$key] = ($meta === false) ? null : $meta[$key];
+                }
+            }
+            $handle->clean();
+            return $redata;
+        }
+        //在一个事务中写入process()返回的新图片，并填入图片ID
+        function insert($results){
+            global $pagecache;
+            $inserted = false;
+            $uploader = $this;
+            $failed = array();
+            $this->database->action(function($database) use ($uploader,&$results,&$inserted,&$failed) {
+                //同一批次中内容相同的图片只写入一次
+                $ids = array();
+                foreach ($results as $i => $result) {
+                    if(!isset($result['row'])) {
+                        continue;
+                    }
+                    $path = $result['row']['path'];
+                    if(!isset($ids[$path])) {
+                        $ids[$path] = $uploader->insertrow($database,$result['row']);
+                        $inserted = true;
+                    }
+                    if($ids[$path] === false) {
+                        $failed[$path] = true;
+                        $results[$i] = array(
+                            "code"  =>  0,
+                            "msg"   =>  "写入数据库失败！"
+                        );
+                        continue;
+                    }
+                    $results[$i]['id'] = $ids[$path];
+                    unset($results[$i]['row']);
+                }
+            });
+            //写入失败的图片删除已保存的文件
+            foreach (array_keys($failed) as $path) {
+                foreach (array('',".webp",".avif") as $ext) {
+                    $this->store->delete($path.$ext);
+                }
+            }
+            //有新图片时使公共页面缓存失效
+            if($inserted) {
+                $pagecache->invalidate();
+            }
+            return $results;
+        }
+        /*
+        写入一条图片记录，返回ID；同时上传相同图片时另一个请求可能已经写入同一路径，违反imginfo_path唯一索引，此时返回已有记录的ID
+        其它错误返回false；PostgreSQL出错后整个事务不能继续执行，每条记录使用一个SAVEPOINT
+        */
+        function insertrow($database,$row){
+            $savepoint = ($this->database->type() == 'pgsql');
+            if($savepoint) {
+                $database->query('SAVEPOINT "imginfo_row"');
+            }
+            //Db已设置为出错时返回错误码，直接使用Medoo等未设置时PHP 8会抛出异常
+            try {
+                $statement = $database->insert("imginfo",$row);
+                $error = $statement ? $statement->errorInfo() : $database->pdo->errorInfo();
+            }
+            catch (PDOException $e) {
+                $error = array($e->getCode());
+            }
+            if($error[0] === '00000') {
+                $id = $database->id();
+                if($savepoint) {
+                    $database->query('RELEASE SAVEPOINT "imginfo_row"');
+                }
+                return $id;
+            }
+            if($savepoint) {
+                $database->query('ROLLBACK TO SAVEPOINT "imginfo_row"');
+            }
+            $id = $database->get("imginfo","id",["path" => $row['path']]);
+            return $id ? $id : false;
+        }
+    }
+?>
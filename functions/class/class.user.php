@@ -57,45 +57,14 @@
                 exit;
             }
         }
-        //检查某张图片是否已经上传
-        function isupload($path){
-            $num = $this->database->count("imginfo",["path"   =>  $path]);
-
-            //如果图片已经上传过，直接返回图片信息
-            if($num >=1) {
-                $info = $this->database->get("imginfo","*",["path"  =>  $path]);
-                $imgurl = $this->config['domain'].$path;
-                //返回json数据
-                $redata = array(
-                    "code"      =>  1,
-                    "id"        =>  $info['id'],
-                    "url"       =>  $imgurl,
-                    "width"     =>  0,
-                    "height"    =>  0
-                );
-                echo $redata = json_encode($redata);
-                exit;
-            }
-        }
-        //限制访客上传数量
-        function limitnum(){
-            //获取访客IP
-            $ip = $_SERVER['REMOTE_ADDR'];
-            //获取当前时间
-            $date = date('Y-m-d',time());
-            //获取配置文件限额
-            $limit = $this->config['limit'];
-            //获取用户上传目录
-            $dir = $this->config['userdir'];
-            //查询数据库统计数量
-            $database = $this->database;
-            $num = $database->count("imginfo",[
-                "date"      =>  $date,
-                "ip"        =>  $ip,
-                "dir"       =>  $dir
-            ]);
+        //限制访客上传数量，使用令牌桶，不再统计imginfo；$num为本次上传的图片数量，返回允许上传的数量，一张也不允许时直接返回错误
+        function limitnum($limiter,$num = 1){
+            $limit = new Limiter($limiter,$this->database,$this->config['limit']);
+            //不使用getip()，客户端可以伪造Client-IP、X-Forwarded-For绕过限制
+            $ip = $limit->clientip();
             
-            if($num >= $limit) {
+            $allowed = $limit->grant($ip,$num);
+            if($allowed == 0) {
                 $redata = array(
                     "code"      =>  0,
                     "msg"       =>  "上传达到限制！"
@@ -103,6 +72,7 @@
                 echo $redata = json_encode($redata);
                 exit;
             }
+            return $allowed;
         }
         //获取访客真实IP
         function getip(){
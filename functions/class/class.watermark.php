@@ -0,0 +1,103 @@
+<?php
+    /*
+    图片水印，文字或Logo按缩略图宽度各生成一次带透明通道的PNG并缓存
+    叠加时交给上传类的image_watermark处理，不需要每张图片都渲染一次TTF文字
+    */
+    class Watermark{
+        var $config;
+
+        //构造函数，$config为配置文件中的$watermark
+        public function __construct($config){
+            $this->config = $config;
+        }
+        //水印标识，水印设置改变后缩略图缓存随之失效
+        function sign(){
+            $config = $this->config;
+            $logo = ($config['logo'] != '') ? $config['logo'].'|'.@filemtime(APP.$config['logo']) : '';
+            return md5($config['text'].'|'.$logo.'|'.$config['font'].'|'.$config['color'].'|'.$config['opacity'].'|'.$config['scale']);
+        }
+        //该宽度的图片是否需要加水印
+        function need($width){
+            return ($this->config['option'] == true) && ($width >= $this->config['minwidth']);
+        }
+        //返回指定宽度使用的水印PNG路径，不存在时生成，失败返回false
+        function overlay($width){
+            $file = APP.$this->config['dir'].'/'.$this->sign().'_'.$width.'.png';
+            if(is_file($file)) {
+                return $file;
+            }
+            //水印宽度按图片宽度的比例计算
+            $max = (int)round($width * $this->config['scale']);
+            $image = ($this->config['logo'] != '') ? $this->logo($max) : $this->text($max);
+            if(!$image) {
+                return false;
+            }
+            if(!is_dir(dirname($file))) {
+                @mkdir(dirname($file),0777,true);
+            }
+            //先写临时文件再更名，避免并发请求读到不完整的水印
+            $tmpfile = $file.'.'.uniqid().'.png';
+            imagesavealpha($image,true);
+            $result = imagepng($image,$tmpfile);
+            imagedestroy($image);
+            if((!$result) || (!rename($tmpfile,$file))) {
+                @unlink($tmpfile);
+                return false;
+            }
+            return $file;
+        }
+        //新建透明画布，四周保留边距
+        function canvas($width,$height,$margin){
+            $image = imagecreatetruecolor($width + $margin * 2,$height + $margin * 2);
+            imagealphablending($image,false);
+            imagefill($image,0,0,imagecolorallocatealpha($image,0,0,0,127));
+            imagealphablending($image,true);
+            return $image;
+        }
+        //渲染文字水印
+        function text($max){
+            $font = APP.$this->config['font'];
+            if((!function_exists('imagettftext')) || (!is_file($font)) || ($this->config['text'] == '')) {
+                return false;
+            }
+            //先按12号字测量，再按比例得到不超过最大宽度的字号
+            $box = imagettfbbox(12,0,$font,$this->config['text']);
+            $size = max(8,12 * $max / max(1,abs($box[2] - $box[0])));
+            $box = imagettfbbox($size,0,$font,$this->config['text']);
+            $width = abs($box[2] - $box[0]);
+            $height = abs($box[7] - $box[1]);
+            $margin = (int)ceil($size / 2);
+            $image = $this->canvas($width,$height,$margin);
+            list($red,$green,$blue) = sscanf($this->config['color'],'#%02x%02x%02x');
+            //透明度0-100转换为GD的alpha 127-0
+            $alpha = 127 - (int)round($this->config['opacity'] * 127 / 100);
+            $color = imagecolorallocatealpha($image,$red,$green,$blue,$alpha);
+            imagettftext($image,$size,0,$margin - $box[0],$margin - $box[7],$color,$font,$this->config['text']);
+            return $image;
+        }
+        //缩放Logo水印
+        function logo($max){
+            $logo = @imagecreatefrompng(APP.$this->config['logo']);
+            if(!$logo) {
+                return false;
+            }
+            $width = imagesx($logo);
+            $height = imagesy($logo);
+            //Logo不放大
+            if($width > $max) {
+                $height = (int)round($height * $max / $width);
+                $width = $max;
+            }
+            $margin = (int)ceil($width / 20);
+            $image = $this->canvas($width,$height,$margin);
+            imagealphablending($image,false);
+            imagecopyresampled($image,$logo,$margin,$margin,0,0,$width,$height,imagesx($logo),imagesy($logo));
+            imagedestroy($logo);
+            //按透明度降低Logo每个像素的不透明度
+            if($this->config['opacity'] < 100) {
+                imagefilter($image,IMG_FILTER_COLORIZE,0,0,0,(int)round((100 - $this->config['opacity']) * 127 / 100));
+            }
+            return $image;
+        }
+    }
+?>
@@ -59,6 +59,7 @@
     $translation['ratio_too_low']               = '图片宽/高比率太低(图片高度太大).';
     $translation['too_many_pixels']             = '图片位数太高。';
     $translation['not_enough_pixels']           = '图片位数不够';
+    $translation['not_enough_memory']           = '图片尺寸太大，内存不足，无法处理。';
     $translation['file_not_uploaded']           = '文件未上传，不能进行处理。';
     $translation['already_exists']              = '%s 已经存在，请更换文件名。';
     $translation['temp_file_missing']           = '处理的(临时)源文件不正确，不能进行处理。';
@@ -62,6 +62,7 @@
     $translation['ratio_too_low']               = '圖片寬高比率太小 (圖片高度太大)。';
     $translation['too_many_pixels']             = '圖片像素太多。';
     $translation['not_enough_pixels']           = '圖片像素太少。';
+    $translation['not_enough_memory']           = '圖片尺寸太大，記憶體不足，無法處理。';
     $translation['file_not_uploaded']           = '檔案未上傳，無法繼續進行處理。';
     $translation['already_exists']              = '%s 已經存在，請更改檔名。';
     $translation['temp_file_missing']           = '暫存的原始檔案不正確，無法繼續進行處理。';
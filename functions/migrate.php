@@ -0,0 +1,154 @@
+<?php
+    /*
+    将SQLite数据迁移到MySQL/PostgreSQL，仅允许命令行运行
+    先在config.php的$dbconfig中填写MySQL/PostgreSQL连接信息，然后执行：
+    php functions/migrate.php [--from=db/imgurl.db3] [--batch=1000] [--sync]
+    目标数据库不存在的表、字段、索引及触发器自动创建；按ID分批读取并写入，每批一个事务，内存占用与数据量无关
+    可重复执行：每次只复制ID大于目标数据库已有最大ID的记录，迁移时站点可以继续使用SQLite
+    切换前停止上传再执行一次，并加上--sync同步已迁移记录的变化（鉴黄等级、压缩状态、删除等）
+    */
+    error_reporting(E_ALL^E_NOTICE^E_WARNING^E_DEPRECATED);
+    if(php_sapi_name() != 'cli') {
+        echo '请在命令行下运行！';
+        exit;
+    }
+    //载入配置文件
+    include_once(__DIR__."/../config.php");
+    set_time_limit(0);
+
+    $options = array();
+    foreach (array_slice($argv,1) as $arg) {
+        if(preg_match('/^--([a-z]+)(=(.*))?$/',$arg,$match)) {
+            $options[$match[1]] = isset($match[3]) ? $match[3] : true;
+        }
+    }
+    $from = isset($options['from']) ? $options['from'] : $config['datadir'];
+    $num = isset($options['batch']) ? max(1,(int)$options['batch']) : 1000;
+
+    if($database->type() == 'sqlite') {
+        echo "请先在config.php中将\$dbconfig['type']设置为mysql或pgsql并填写连接信息。\n";
+        exit(1);
+    }
+    if(!is_file($from)) {
+        echo "SQLite数据库不存在：".$from."\n";
+        exit(1);
+    }
+    //源数据库只读取，不需要WAL等设置
+    $source = new Db([
+        'database_type' => 'sqlite',
+        'database_file' => $from
+    ]);
+
+    //建立目标数据库的表结构
+    $schema = new Schema($database);
+    if(!$schema->run($schema->sqls())) {
+        echo "建立表结构失败：".$schema->error."\n";
+        exit(1);
+    }
+    $tables = $schema->tables();
+
+    //两边都有的字段，旧版本的SQLite数据库可能缺少新增字段
+    function columns($source,$table,$define){
+        $columns = $source->query('PRAGMA table_info("'.$table.'")')->fetchAll(PDO::FETCH_COLUMN,1);
+        return array_values(array_intersect($columns,array_keys($define['columns'])));
+    }
+
+    //带自增ID的表按ID分批复制，limiter为临时数据不迁移
+    foreach (array("imginfo","sm","queue") as $table) {
+        $columns = columns($source,$table,$tables[$table]);
+        if(empty($columns)) {
+            echo $table."：源数据库中不存在，跳过\n";
+            continue;
+        }
+        $cursor = (int)$database->max($table,"id");
+        $total = 0;
+        //同步已迁移的记录：源数据库中已删除的记录删除，内容不同的记录更新
+        if(isset($options['sync']) && ($cursor > 0)) {
+            $synced = 0;
+            $removed = 0;
+            for($start = 0;$start < $cursor;$start += $num) {
+                $where = ["id[>]" => $start,"id[<=]" => min($cursor,$start + $num)];
+                $rows = array();
+                foreach ($source->select($table,$columns,$where) as $row) {
+                    $rows[$row['id']] = $row;
+                }
+                $targets = array();
+                foreach ($database->select($table,$columns,$where) as $row) {
+                    $targets[$row['id']] = $row;
+                }
+                $deleted = array_keys(array_diff_key($targets,$rows));
+                $database->action(function($database) use ($table,$rows,$targets,$deleted,&$synced) {
+                    if(!empty($deleted)) {
+                        $database->delete($table,["id" => $deleted]);
+                    }
+                    foreach ($rows as $id => $row) {
+                        //新增的记录由后面的复制写入
+                        if(!isset($targets[$id])) {
+                            continue;
+                        }
+                        //数据库返回的类型不同，按字符串比较
+                        $changed = array_diff_assoc(array_map('strval',$row),array_map('strval',$targets[$id]));
+                        if(!empty($changed)) {
+                            $database->update($table,array_intersect_key($row,$changed),["id" => $id]);
+                            $synced++;
+                        }
+                    }
+                });
+                $removed += count($deleted);
+            }
+            echo $table."：已同步".$synced."条变化，删除".$removed."条\n";
+        }
+        while(true) {
+            $rows = $source->select($table,$columns,[
+                "id[>]"     =>  $cursor,
+                "ORDER"     =>  ["id" => "ASC"],
+                "LIMIT"     =>  $num
+            ]);
+            if(empty($rows)) {
+                break;
+            }
+            //一条INSERT写入一批，失败时回滚本批，下次执行从该批重新开始
+            $result = $database->action(function($database) use ($table,$rows) {
+                $statement = $database->insert($table,$rows);
+                return ($statement && ($statement->rowCount() == count($rows))) ? true : false;
+            });
+            if(!$result) {
+                $error = $database->error();
+                echo $table."：写入失败（ID ".$rows[0]['id']." 开始）：".$error[2]."\n";
+                exit(1);
+            }
+            $last = end($rows);
+            $cursor = (int)$last['id'];
+            $total += count($rows);
+            echo $table."：已复制".$total."条\n";
+        }
+        //PostgreSQL显式写入ID后自增序列不会变化，需要设置为最大ID
+        if(($database->type() == 'pgsql') && ($cursor > 0)) {
+            if(!$schema->run(array("SELECT setval(pg_get_serial_sequence('".$table."','id'),".(int)$cursor.")"))) {
+                echo $table."：设置自增序列失败：".$schema->error."\n";
+                exit(1);
+            }
+        }
+        echo $table."：完成，新增".$total."条\n";
+    }
+
+    //TinyPNG key每月使用次数，数据量很小，逐条写入或更新
+    $columns = columns($source,"tinykey",$tables['tinykey']);
+    if(!empty($columns)) {
+        foreach ($source->select("tinykey",$columns) as $row) {
+            if($database->has("tinykey",["key" => $row['key']])) {
+                $database->update("tinykey",$row,["key" => $row['key']]);
+            }
+            else{
+                $database->insert("tinykey",$row);
+            }
+        }
+    }
+
+    //触发器在复制时已更新统计，--sync的修改也会触发，重新生成一次保证与数据一致
+    if(!$schema->run(array_merge($schema->rebuild(),array($schema->analyze())))) {
+        echo "重新生成统计失败：".$schema->error."\n";
+        exit(1);
+    }
+    echo "迁移完成，确认数据无误后即可使用新的数据库。\n";
+?>
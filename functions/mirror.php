@@ -0,0 +1,76 @@
+<?php
+    /*
+    批量镜像及清理，仅允许命令行运行，只写入后台任务，由functions/worker.php并发处理
+    php functions/mirror.php upload             将所有未镜像的图片镜像到远程图床
+    php functions/mirror.php delete [2018-05-01]  删除SM.MS图片（可指定只删除该日期之前的）
+    */
+    error_reporting(E_ALL^E_NOTICE^E_WARNING^E_DEPRECATED);
+    if(php_sapi_name() != 'cli') {
+        echo '请在命令行下运行！';
+        exit;
+    }
+    //载入配置文件
+    include_once(__DIR__."/../config.php");
+
+    set_time_limit(0);
+    $type = isset($argv[1]) ? $argv[1] : '';
+    $jobs = new Queue($queue,$database);
+    //每批处理的数量，每批在一个事务中写入
+    $num = 500;
+    $cursor = 0;
+    $total = 0;
+
+    switch ($type) {
+        case 'upload':
+            while(true) {
+                $ids = $database->select("imginfo","id",[
+                    "id[>]" =>  $cursor,
+                    "ORDER" =>  ["id" => "ASC"],
+                    "LIMIT" =>  $num
+                ]);
+                if(empty($ids)) {
+                    break;
+                }
+                $cursor = end($ids);
+                //没有sm记录的图片都写入任务，包括镜像后又被删除的图片（之前的任务已完成，重新设置为待处理）
+                $ids = array_diff($ids,$database->select("sm","imgid",["imgid" => $ids]));
+                $database->action(function($database) use ($ids,$jobs) {
+                    foreach ($ids as $id) {
+                        $jobs->push('mirror',$id);
+                    }
+                });
+                $total += count($ids);
+            }
+            break;
+        case 'delete':
+            $date = isset($argv[2]) ? $argv[2] : '';
+            while(true) {
+                $where = [
+                    "id[>]" =>  $cursor,
+                    "ORDER" =>  ["id" => "ASC"],
+                    "LIMIT" =>  $num
+                ];
+                if($date != '') {
+                    $where["date[<]"] = $date;
+                }
+                $datas = $database->select("sm",["id","delete"],$where);
+                if(empty($datas)) {
+                    break;
+                }
+                $cursor = $datas[count($datas) - 1]['id'];
+                //先删除记录再写入任务，删除链接保存在任务数据中
+                $database->action(function($database) use ($datas,$jobs) {
+                    $database->delete("sm",["id" => array_column($datas,'id')]);
+                    foreach ($datas as $sm) {
+                        $jobs->push('smdelete',$sm['id'],array("delete" => $sm['delete']));
+                    }
+                });
+                $total += count($datas);
+            }
+            break;
+        default:
+            echo "用法：php functions/mirror.php upload|delete [日期]\n";
+            exit;
+    }
+    echo "已写入".$total."个任务，请运行 php functions/worker.php 处理\n";
+?>
@@ -0,0 +1,40 @@
+<?php
+    /*
+    opcache预加载列表（PHP 7.4+），在php.ini中设置：
+    opcache.preload=/网站目录/functions/preload.php
+    opcache.preload_user=www
+    只编译类文件，不会执行其中的代码；需要执行的页面（如class.user.php）不要加入
+    */
+    $files = array(
+        "functions/class/Medoo.php",
+        "functions/class/class.db.php",
+        "functions/class/class.cache.php",
+        "functions/class/class.limiter.php",
+        "functions/class/class.queue.php",
+        "functions/class/class.dispose.php",
+        "functions/class/class.optimizer.php",
+        "functions/class/class.uploader.php",
+        "functions/class/class.watermark.php",
+        "functions/class/class.storage.php",
+        "functions/class/class.s3storage.php",
+        "functions/class/class.ossstorage.php",
+        "functions/class/class.pool.php",
+        "functions/class/class.sm.php",
+        "functions/class/class.phash.php",
+        "functions/class/class.metrics.php",
+        "functions/class/class.found.php",
+        "functions/class/class.upload.php",
+        "functions/class/class.schema.php",
+        "functions/class/class.exif.php",
+        "functions/class/class.reconcile.php",
+        "functions/tinypng/Tinify/Exception.php",
+        "functions/tinypng/Tinify/ResultMeta.php",
+        "functions/tinypng/Tinify/Result.php",
+        "functions/tinypng/Tinify/Source.php",
+        "functions/tinypng/Tinify/Client.php",
+        "functions/tinypng/Tinify.php"
+    );
+    foreach ($files as $file) {
+        opcache_compile_file(__DIR__."/../".$file);
+    }
+?>
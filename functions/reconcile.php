@@ -0,0 +1,72 @@
+<?php
+    /*
+    图片文件与数据库对账，仅允许命令行运行
+    php functions/reconcile.php             只输出报告，每行为 类型<TAB>路径<TAB>大小或ID
+        orphan：数据库中没有记录的图片文件；garbage：处理中断留下的临时文件；dangling：图片文件已丢失的记录
+    php functions/reconcile.php --purge     同时删除以上文件及记录
+    可选参数：--phase=files|rows 只执行其中一步；--time=3600 运行指定秒数后保存断点退出；--restart 忽略断点重新开始
+    每批处理完成后保存断点，中断或超时后再次执行从断点继续，全部完成后删除断点
+    孤立文件只检查本地上传目录，使用S3/OSS时不会列出对象存储中的文件；记录检查对对象存储发送HEAD请求
+    */
+    error_reporting(E_ALL^E_NOTICE^E_WARNING^E_DEPRECATED);
+    if(php_sapi_name() != 'cli') {
+        echo '请在命令行下运行！';
+        exit;
+    }
+    //载入配置文件
+    include_once(__DIR__."/../config.php");
+    set_time_limit(0);
+
+    $options = array();
+    foreach (array_slice($argv,1) as $arg) {
+        if(preg_match('/^--([a-z]+)(=(.*))?$/',$arg,$match)) {
+            $options[$match[1]] = isset($match[3]) ? $match[3] : true;
+        }
+    }
+    $phases = isset($options['phase']) ? array_intersect(array('files','rows'),explode(',',$options['phase'])) : array('files','rows');
+
+    $reconciler = new Reconcile($reconcile,$database,Storage::create($storage,$config['domain']),array($config['userdir'],$config['admindir']));
+    //同一时间只允许一个进程对账
+    if(!is_dir(dirname($reconciler->file()))) {
+        @mkdir(dirname($reconciler->file()),0777,true);
+    }
+    $lock = fopen($reconciler->file().'.lock','c');
+    if((!$lock) || (!flock($lock,LOCK_EX | LOCK_NB))) {
+        echo "已有对账进程正在运行。\n";
+        exit(1);
+    }
+    if(isset($options['restart'])) {
+        $reconciler->reset();
+    }
+    $reconciler->purge = isset($options['purge']);
+    if(isset($options['time'])) {
+        $reconciler->deadline = time() + (int)$options['time'];
+    }
+
+    if(($storage['driver'] != 'local') && in_array('files',$phases)) {
+        echo "# 注意：孤立文件只检查本地上传目录，对象存储中没有本地文件的孤立对象不会被发现\n";
+    }
+    $finished = $reconciler->run($phases);
+    if($reconciler->aborted != '') {
+        echo "# ".$reconciler->aborted."\n";
+        flock($lock,LOCK_UN);
+        fclose($lock);
+        exit(1);
+    }
+    $stats = $reconciler->state['stats'];
+    echo "# 已检查文件".$stats['files']."个、记录".$stats['rows']."条；";
+    echo "孤立文件".$stats['orphan']."个（".round($stats['orphan_bytes'] / 1048576,2)."MB），临时文件".$stats['garbage']."个（".round($stats['garbage_bytes'] / 1048576,2)."MB），文件丢失的记录".$stats['dangling']."条";
+    echo $reconciler->purge ? "，已删除\n" : "\n";
+    if($finished) {
+        //所有步骤都已完成时删除断点，下次重新开始
+        if(count($phases) == 2) {
+            $reconciler->reset();
+        }
+        echo "# 对账完成\n";
+    }
+    else{
+        echo "# 已到运行时间，断点已保存，再次执行将从断点继续\n";
+    }
+    flock($lock,LOCK_UN);
+    fclose($lock);
+?>
@@ -4,6 +4,34 @@
     //检查用户是否登录
     $status = $basis->check($config);
 
+    //单张上传使用file字段，批量上传使用file[]字段，统一整理为多个文件
+    $batch = is_array($_FILES['file']['name']);
+    $files = array();
+    if($batch) {
+        foreach ($_FILES['file']['name'] as $i => $name) {
+            $files[] = array(
+                "name"      =>  $name,
+                "type"      =>  $_FILES['file']['type'][$i],
+                "tmp_name"  =>  $_FILES['file']['tmp_name'][$i],
+                "error"     =>  $_FILES['file']['error'][$i],
+                "size"      =>  $_FILES['file']['size'][$i]
+            );
+        }
+    }
+    else{
+        $files[] = $_FILES['file'];
+    }
+    //单次上传数量限制
+    if(count($files) > $config['batch']) {
+        echo json_encode(array(
+            "code"  =>  0,
+            "msg"   =>  "单次最多上传".$config['batch']."张图片！"
+        ));
+        exit;
+    }
+
+    //允许上传的数量，游客额度不足时只处理前面的图片
+    $allowed = count($files);
     //检查用户是否登陆来判断上传目录
     if($status == 'islogin') {
         //设置上传路径
@@ -11,85 +39,47 @@
     }
     else{
         $updir = $config['userdir'];
-        //限制用户上传数量
-        $basis->limitnum();
+        //请求体明显超过上传大小限制时直接拒绝，不再计算hash和载入上传类
+        if((int)$_SERVER['CONTENT_LENGTH'] > count($files) * 2097152 + 65536) {
+            echo json_encode(array(
+                "code"  =>  0,
+                "msg"   =>  "图片大小超过限制！"
+            ));
+            exit;
+        }
+        //限制用户上传数量，每张图片消耗一次额度
+        $allowed = $basis->limitnum($limiter,count($files));
     }
 
     //获取上传者信息
     $ip = $basis->getip();
     $ua = $_SERVER['HTTP_USER_AGENT'];
-    $date = date('Y-m-d',time());
-    //载入上传类
-    include('./class/class.upload.php');
-
-    //上传方法
-    $handle = new upload($_FILES['file']);
-    if ($handle->uploaded) {
-        $handle->file_new_name_body   = 'image_resized';
-        //允许上传大小2m
-        $handle->file_max_size = '2097152';
-        //允许的MIME类型，仅运行上传图片
-        $handle->allowed = array('image/*');
-
-        // 当前月份
-        $current_time = date('ym',time());
-        //上传路径：目录 + 时间
-        $handle->process('../'.$updir.'/'.$current_time."/");
-        if ($handle->processed) {
-            //获取站点域名
-            $domain = $config['domain'];
-            //生成文件hash
-            $fhash = hash_file("md5",$handle->file_dst_pathname,FALSE);
-            $fhash = substr($fhash,8,16);
-            //新的文件名(../temp/1804/\d64c8036c0605175.jpg)
-            $new_img = $handle->file_dst_path.$fhash.'.'.$handle->file_dst_name_ext;
-            //图片URL地址
-            $imgurl = $domain.$updir.'/'.$current_time.'/'.$fhash.'.'.$handle->file_dst_name_ext;
-            //图片路径(temp/1804/d64c8036c0605175.jpg)
-            $imgdir = $updir.'/'.$current_time.'/'.$fhash.'.'.$handle->file_dst_name_ext;
-
-            //判断文件是否已经存在
-            if(!is_file($new_img)) {
-                //对文件更名
-                rename($handle->file_dst_pathname,$new_img);
-            }
-            else{
-                //删除原始文件
-                unlink($handle->file_dst_pathname);
-            }
 
-            //检查某张图片是否已经上传过，如果已经上传了，直接返回数据并终止操作
-            $basis->isupload($imgdir);
-
-            //没有上传过的图片，继续写入数据库
-            $last_user_id = $database->insert("imginfo", [
-                "path"      =>  $imgdir,
-                "ip"        =>  $ip,
-                "ua"        =>  $ua,
-                "date"      =>  $date,
-                "dir"       =>  $updir,
-                "compress"  =>  0,
-                "level"     =>  0
-            ]);
-            //返回最后的ID
-            $account_id = $database->id();
-            //上传成功，返回json数据
-            $redata = array(
-                "code"      =>  1,
-                "id"        =>  $account_id,
-                "url"       =>  $imgurl,
-                "width"     =>  $handle->image_dst_x,
-                "height"    =>  $handle->image_dst_y
+    $uploader = new Uploader($config,$database,$optimize,$queue,$storage,$exif);
+    $results = array();
+    foreach ($files as $i => $file) {
+        if($i >= $allowed) {
+            $results[] = array(
+                "code"  =>  0,
+                "msg"   =>  "上传达到限制！",
+                "name"  =>  $file['name']
             );
-            echo $redata = json_encode($redata);
-            $handle->clean();
-        } else {
+            continue;
+        }
+        $result = $uploader->process($file,$updir,$ip,$ua);
+        if($result === false) {
             //上传出现错误，返回报错信息
-            $redata = array(
+            $result = array(
                 "code"  =>  0,
-                "msg"   =>  $handle->error
+                "msg"   =>  $uploader->error,
+                "name"  =>  $file['name']
             );
-            echo json_encode($redata);
         }
+        $results[] = $result;
     }
-?>
\ No newline at end of file
+    //新图片在一个事务中写入数据库
+    $results = $uploader->insert($results);
+
+    //批量上传返回数组，单张上传保持原来的格式
+    echo json_encode($batch ? $results : $results[0]);
+?>
@@ -0,0 +1,190 @@
+<?php
+    /*
+    后台任务处理进程，仅允许命令行运行
+    php functions/worker.php            处理当前所有任务后退出，适合crontab每分钟执行
+    php functions/worker.php daemon     常驻运行，没有任务时等待
+    */
+    error_reporting(E_ALL^E_NOTICE^E_WARNING^E_DEPRECATED);
+    if(php_sapi_name() != 'cli') {
+        echo '请在命令行下运行！';
+        exit;
+    }
+    //载入配置文件
+    include_once(__DIR__."/../config.php");
+
+    //处理一批镜像任务，mirror上传本站图片（target为imginfo ID），smdelete请求删除链接（target为sm ID）
+    function mirror($remote,$jobs,$sm,$store){
+        global $database;
+        $images = array();
+        $links = array();
+        $results = array();
+        foreach ($remote as $key => $job) {
+            if($job['type'] == 'smdelete') {
+                $data = json_decode($job['data'],true);
+                $links[$key] = $data['delete'];
+                continue;
+            }
+            $info = $database->get("imginfo",["id","path"],["id" => $job['target']]);
+            //图片已被删除或已经镜像过，任务直接完成
+            if((!$info) || $database->has("sm",["imgid" => $info['id']])) {
+                $results[$key] = true;
+                continue;
+            }
+            $file = $store->fetch($info['path']);
+            if($file === false) {
+                $results[$key] = '图片不存在！';
+                continue;
+            }
+            $images[$key] = array("id" => $info['id'],"file" => $file,"path" => $info['path']);
+        }
+        $results = $results + $sm->delete($links) + $sm->upload($images);
+        foreach ($images as $img) {
+            $store->release($img['path']);
+        }
+        foreach ($remote as $key => $job) {
+            if($results[$key] === true) {
+                $jobs->done($job);
+                echo date('Y-m-d H:i:s',time())." ".$job['type']." #".$job['target']." ok\n";
+            }
+            else{
+                $jobs->fail($job,$results[$key]);
+                echo date('Y-m-d H:i:s',time())." ".$job['type']." #".$job['target']." failed: ".$results[$key]."\n";
+            }
+        }
+    }
+
+    //处理一批鉴黄任务，已删除或已鉴黄的图片直接完成
+    function moderate($list,$jobs,$dispose){
+        global $database;
+        $ids = array();
+        foreach ($list as $job) {
+            $ids[] = $job['target'];
+        }
+        $infos = array();
+        foreach ($database->select("imginfo",["id","path","compress","level"],["id" => $ids]) as $info) {
+            $infos[$info['id']] = $info;
+        }
+        $pending = array();
+        foreach ($list as $key => $job) {
+            if(isset($infos[$job['target']]) && $dispose->needmoderate($infos[$job['target']])) {
+                $pending[$key] = $infos[$job['target']];
+            }
+        }
+        $levels = $dispose->moderatebatch($pending);
+        foreach ($list as $key => $job) {
+            if(isset($levels[$key]) && ($levels[$key] === false)) {
+                $jobs->fail($job,$dispose->errors[$key]);
+                echo date('Y-m-d H:i:s',time())." moderate #".$job['target']." failed: ".$dispose->errors[$key]."\n";
+            }
+            else{
+                $jobs->done($job);
+                echo date('Y-m-d H:i:s',time())." moderate #".$job['target']." ok\n";
+            }
+        }
+    }
+
+    set_time_limit(0);
+    $daemon = (isset($argv[1]) && ($argv[1] == 'daemon'));
+    //非常驻模式下单次最长运行时间，避免与下一次crontab重叠
+    $deadline = time() + 50;
+
+    $jobs = new Queue($queue,$database);
+    $dispose = new Dispose($config,$database,$tinypng,$ModerateContent,$storage);
+    $optimizer = new Optimizer($optimize);
+    $sm = new Sm($mirror,$database);
+
+    while(true) {
+        $list = $jobs->claim();
+        if(empty($list)) {
+            if(!$daemon) {
+                break;
+            }
+            sleep($queue['sleep']);
+            continue;
+        }
+
+        //镜像上传及删除任务交给连接池一起并发处理
+        $remote = array();
+        foreach ($list as $i => $job) {
+            if(in_array($job['type'],array('mirror','smdelete'))) {
+                $remote[$job['id']] = $job;
+                unset($list[$i]);
+            }
+        }
+        if(!empty($remote)) {
+            mirror($remote,$jobs,$sm,$dispose->store);
+        }
+        //鉴黄任务同样批量并发请求
+        $moderate = array();
+        foreach ($list as $i => $job) {
+            if($job['type'] == 'moderate') {
+                $moderate[$job['id']] = $job;
+                unset($list[$i]);
+            }
+        }
+        if(!empty($moderate)) {
+            moderate($moderate,$jobs,$dispose);
+        }
+
+        foreach ($list as $job) {
+            //查询对应图片
+            $info = $database->get("imginfo",[
+                "id",
+                "path",
+                "compress",
+                "level"
+            ],[
+                "id"    =>  $job['target']
+            ]);
+            //图片已被删除，任务直接完成
+            if(!$info) {
+                $jobs->done($job);
+                continue;
+            }
+
+            switch ($job['type']) {
+                case 'compress':
+                    $result = $dispose->needcompress($info) ? $dispose->compress($info) : 1;
+                    break;
+                case 'moderate':
+                    $result = $dispose->needmoderate($info) ? $dispose->moderate($info) : $info['level'];
+                    break;
+                case 'variant':
+                    //生成WebP/AVIF，已存在或不支持的格式直接跳过；使用对象存储时上传后释放本地文件
+                    $result = 1;
+                    $file = $dispose->store->fetch($info['path']);
+                    if($file === false) {
+                        $result = false;
+                        $dispose->error = '图片不存在！';
+                        break;
+                    }
+                    $optimizer->variants($file);
+                    foreach (array('','.webp','.avif') as $suffix) {
+                        if(($suffix != '') && is_file($file.$suffix) && (!$dispose->store->put($file.$suffix,$info['path'].$suffix))) {
+                            $result = false;
+                            $dispose->error = $dispose->store->error;
+                        }
+                        $dispose->store->release($info['path'].$suffix);
+                    }
+                    break;
+                default:
+                    $result = false;
+                    $dispose->error = '未知的任务类型！';
+                    break;
+            }
+
+            if($result === false) {
+                $jobs->fail($job,$dispose->error);
+                echo date('Y-m-d H:i:s',time())." ".$job['type']." #".$info['id']." failed: ".$dispose->error."\n";
+            }
+            else{
+                $jobs->done($job);
+                echo date('Y-m-d H:i:s',time())." ".$job['type']." #".$info['id']." ok\n";
+            }
+        }
+
+        if((!$daemon) && (time() >= $deadline)) {
+            break;
+        }
+    }
+?>
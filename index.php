@@ -1,4 +1,8 @@
 <?php
+    // 载入配置文件，页面缓存命中时直接输出
+    include_once("./config.php");
+    $pagecache->page("index",$cache['page']);
+
     $title = "ImgURL - 简单、纯粹的图床程序。";
     include_once("./tpl/user/header.php");
 ?>
@@ -6,7 +10,7 @@
 <div class="layui-container">
     <div class="layui-row">
         <div class="layui-col-lg12 layui-col-xs10">
-        <div class="msg"><i class="layui-icon">&#xe645;</i>  注意：您上传的图片将会公开显示，勿上传隐私图片。游客限制每天5张，最大支持2M</div>
+        <div class="msg"><i class="layui-icon">&#xe645;</i>  注意：您上传的图片将会公开显示，勿上传隐私图片。游客限制每天5张，最大支持20M</div>
             <!-- 上传图片表单 -->
             <div class="layui-upload-drag" id="upimg">
                 <i class="layui-icon">&#xe67c;</i>
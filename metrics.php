@@ -0,0 +1,30 @@
+<?php
+    /*
+    性能统计输出，Prometheus格式：metrics.php?token=xxx
+    需要在配置文件中开启$monitor，并安装APCu（命令行进程需要开启apc.enable_cli才会统计）
+    */
+    error_reporting(E_ALL^E_NOTICE^E_WARNING^E_DEPRECATED);
+    //载入配置文件
+    include_once("./config.php");
+
+    if($monitor['option'] != true) {
+        header("HTTP/1.1 404 Not Found");
+        exit;
+    }
+    //设置了令牌时校验令牌，否则只允许本机访问
+    if($monitor['token'] != '') {
+        $token = isset($_GET['token']) ? $_GET['token'] : str_replace('Bearer ','',$_SERVER['HTTP_AUTHORIZATION']);
+        $allow = hash_equals($monitor['token'],(string)$token);
+    }
+    else{
+        $allow = in_array($_SERVER['REMOTE_ADDR'],array('127.0.0.1','::1'));
+    }
+    if(!$allow) {
+        header("HTTP/1.1 403 Forbidden");
+        exit;
+    }
+
+    header('Content-Type: text/plain; version=0.0.4; charset=utf-8');
+    header('Cache-Control: no-store');
+    echo $metrics->export();
+?>
@@ -0,0 +1,94 @@
+<?php
+    /*
+    图片输出：serve.php?path=temp/1805/d64c8036c0605175.jpg
+    用于无法配置格式协商的服务器，将上传目录重写到此文件即可，例如：
+    rewrite ^/(upload|temp)/(.+)$ /serve.php?path=$1/$2 last;
+    */
+    error_reporting(E_ALL^E_NOTICE^E_WARNING^E_DEPRECATED);
+    //载入配置文件
+    include_once("./config.php");
+
+    //获取参数
+    $path = $_GET['path'];
+
+    //只允许访问上传目录内的图片
+    $dir = explode('/',$path);
+    if(($path == '') || (strpos($path,'..') !== false) || (!in_array($dir[0],array($config['userdir'],$config['admindir'])))) {
+        header("HTTP/1.1 404 Not Found");
+        exit;
+    }
+    //使用对象存储且本地没有该文件时，跳转到对象存储的地址
+    if(!is_file(APP.$path)) {
+        if(($storage['driver'] != 'local') && ($storage['url'] != '')) {
+            header('Location: '.Storage::create($storage,$config['domain'])->url($path),true,302);
+            exit;
+        }
+        header("HTTP/1.1 404 Not Found");
+        exit;
+    }
+
+    //根据后缀获取MIME类型
+    $mimes = array(
+        "jpg"   =>  "image/jpeg",
+        "jpeg"  =>  "image/jpeg",
+        "png"   =>  "image/png",
+        "gif"   =>  "image/gif",
+        "bmp"   =>  "image/bmp",
+        "webp"  =>  "image/webp",
+        "avif"  =>  "image/avif"
+    );
+    $ext = strtolower(substr(strrchr($path, '.'), 1));
+    $file = APP.$path;
+    $mime = isset($mimes[$ext]) ? $mimes[$ext] : 'application/octet-stream';
+
+    //浏览器支持AVIF/WebP且存在同名文件时输出对应格式
+    $accept = isset($_SERVER['HTTP_ACCEPT']) ? $_SERVER['HTTP_ACCEPT'] : '';
+    if(($ext == 'jpg') || ($ext == 'jpeg') || ($ext == 'png')) {
+        header('Vary: Accept');
+        foreach (array("avif" => "image/avif","webp" => "image/webp") as $format => $type) {
+            if((strpos($accept,$type) !== false) && is_file($file.'.'.$format)) {
+                $file = $file.'.'.$format;
+                $mime = $type;
+                break;
+            }
+        }
+    }
+
+    //强ETag使用图片的内容hash：新图片的文件名即完整hash，旧图片从数据库中读取
+    $name = basename($path,'.'.$ext);
+    if(preg_match('/^[0-9a-f]{32,}$/',$name)) {
+        $hash = $name;
+    }
+    else{
+        $hash = $database->get("imginfo","hash",array("path" => $path));
+    }
+    //TinyPNG压缩会原地覆盖文件，加上修改时间及实际输出的格式
+    $mtime = filemtime($file);
+    $etag = ($hash != '') ? $hash : md5($path);
+    $etag = '"'.$etag.'-'.dechex($mtime).(($file != APP.$path) ? '-'.substr(strrchr($file,'.'),1) : '').'"';
+
+    //开启TinyPNG时JPEG/PNG原图会在上传后被原地压缩覆盖，压缩完成之前每次通过ETag验证，完成后才允许浏览器及CDN长期缓存
+    $immutable = true;
+    if(($tinypng['option'] == true) && in_array(strtolower(substr(strrchr($path,'.'),1)),array('jpg','jpeg','png'))) {
+        $immutable = ($database->get("imginfo","compress",array("path" => $path)) == 1);
+    }
+    header('Cache-Control: '.($immutable ? 'public, max-age=31536000, immutable' : 'public, no-cache'));
+    header('ETag: '.$etag);
+    header('Last-Modified: '.gmdate('D, d M Y H:i:s',$mtime).' GMT');
+    //If-None-Match优先于If-Modified-Since
+    if(isset($_SERVER['HTTP_IF_NONE_MATCH'])) {
+        $match = array_map('trim',explode(',',$_SERVER['HTTP_IF_NONE_MATCH']));
+        if(in_array($etag,$match) || in_array('*',$match)) {
+            header("HTTP/1.1 304 Not Modified");
+            exit;
+        }
+    }
+    else if(isset($_SERVER['HTTP_IF_MODIFIED_SINCE']) && (strtotime($_SERVER['HTTP_IF_MODIFIED_SINCE']) >= $mtime)) {
+        header("HTTP/1.1 304 Not Modified");
+        exit;
+    }
+
+    header('Content-Type: '.$mime);
+    header('Content-Length: '.filesize($file));
+    readfile($file);
+?>
@@ -1,6 +1,8 @@
 //layui 根目录配置
 layui.config({
     base: '/static/layui/',
+    //模块地址加上版本号，配合static/.htaccess长期缓存
+    version: '2.2.6'
 })
 //载入layui组建
 layui.use(['layer', 'form','element','upload','flow'], function(){
@@ -17,43 +19,23 @@ layui.use(['layer', 'form','element','upload','flow'], function(){
     	elem:'#adminpic img'
  	});
 
-    //首页拖拽上传
+    //首页拖拽上传，支持多选，选中的图片分批提交
     upload.render({
         elem: '#upimg'
         ,url: 'functions/upload.php'
-        ,size: 2048         //限制上传大小为2M
-        ,before: function(obj){ //obj参数包含的信息，跟 choose回调完全一致，可参见上文。
-            layer.load(); //上传loading
-        }
-        ,done: function(res){
-            //如果上传失败
-            if(res.code == 0){
-                layer.open({
-                    title: '温馨提示'
-                    ,content: res.msg
-                });  
-                layer.closeAll('loading');  
-            }
-            else if(res.code == 1){
-                layer.closeAll('loading'); 
-                $("#showpic a").attr('href',res.url);
-                $("#showpic img").attr('src',res.url);
-                $("#url").val(res.url);
-                $("#html").val("<img src = '" + res.url + "' />");
-                $("#markdown").val("![](" + res.url + ")");
-                $("#bbcode").val("[img]" + res.url + "[/img]");
-                $("#upok").show();
-                //请求接口处理图片
-                $.get("./dispose.php?id="+res.id,function(data,status){
-                    var obj = eval('(' + data + ')');
-                    if(obj.level == 3){
-                        layer.open({
-                            title: '温馨提示'
-                            ,content: '请勿上传违规图片！'
-                        }); 
-                    }
-                });
+        ,size: 20480        //超过2M的图片使用分片上传，最大20M，与config.php中的$chunk保持一致
+        ,multiple: true
+        ,auto: false
+        ,number: 50
+        ,choose: function(obj){
+            //取出本次选择的图片，并从队列中移除，避免下次选择时重复上传
+            var files = obj.pushFile();
+            var list = [];
+            for(var index in files){
+                list.push(files[index]);
+                delete files[index];
             }
+            upbatch(list);
         }
     });
     //上传到sm.ms
@@ -90,6 +72,209 @@ layui.use(['layer', 'form','element','upload','flow'], function(){
     //上传到sm.ms end
 });
 
+//分批上传图片，每批的数量不能超过config.php中的batch；超过2M的图片逐张分片上传
+function upbatch(list){
+    var size = 10;
+    var results = [];
+    var large = [];
+    var small = [];
+    for(var i = 0;i < list.length;i++){
+        if(list[i].size > 2097152){
+            large.push(list[i]);
+        }
+        else{
+            small.push(list[i]);
+        }
+    }
+    list = small;
+    layer.load(); //上传loading
+    var nextlarge = function(index){
+        if(index >= large.length){
+            layer.closeAll('loading');
+            upshow(results);
+            return;
+        }
+        upchunk(large[index],function(res){
+            results.push(res);
+            nextlarge(index + 1);
+        });
+    };
+    var next = function(start){
+        if(start >= list.length){
+            nextlarge(0);
+            return;
+        }
+        var form = new FormData();
+        for(var i = start;i < Math.min(start + size,list.length);i++){
+            form.append('file[]',list[i]);
+        }
+        $.ajax({
+            url: 'functions/upload.php'
+            ,type: 'POST'
+            ,data: form
+            ,dataType: 'json'
+            ,processData: false
+            ,contentType: false
+            ,success: function(res){
+                //整批被拒绝（如达到上传限制）时返回的是单个对象
+                results = results.concat($.isArray(res) ? res : [res]);
+                next(start + size);
+            }
+            ,error: function(){
+                results.push({code:0,msg:'上传失败，请重试！'});
+                next(start + size);
+            }
+        });
+    };
+    next(0);
+}
+
+//分片上传一张图片，token保存在localStorage中，网络中断或刷新页面后重新选择同一张图片会从已上传的位置继续
+function upchunk(file,done){
+    var api = 'functions/chunk.php';
+    var key = 'imgurl_chunk_' + file.name + '_' + file.size + '_' + file.lastModified;
+    var size = 1048576;
+    var retry = 0;
+    var store = window.localStorage;
+    //开始新的上传
+    var start = function(){
+        $.post(api + '?action=init',{name:file.name,size:file.size},function(res){
+            if(res.code == 1){
+                size = res.chunksize;
+                if(store){
+                    store.setItem(key,res.token);
+                }
+                send(res.token,0);
+            }
+            else{
+                done(res);
+            }
+        },'json').fail(function(){
+            done({code:0,msg:'上传失败，请重试！'});
+        });
+    };
+    //请求失败时等待后查询服务器上的进度再继续，最多重试5次
+    var resume = function(token){
+        if(retry >= 5){
+            done({code:0,msg:'上传中断，请重新选择图片继续上传！'});
+            return;
+        }
+        var delay = retry * 2000;
+        retry++;
+        setTimeout(function(){
+            $.get(api + '?action=status&token=' + token,function(res){
+                if(res.code == 1){
+                    size = res.chunksize;
+                    send(token,res.offset);
+                }
+                else{
+                    start();
+                }
+            },'json').fail(function(){
+                resume(token);
+            });
+        },delay);
+    };
+    //上传分片，全部上传完成后通知服务器处理图片
+    var send = function(token,offset){
+        if(offset >= file.size){
+            $.post(api + '?action=finish&token=' + token,function(res){
+                if(store){
+                    store.removeItem(key);
+                }
+                done(res);
+            },'json').fail(function(){
+                resume(token);
+            });
+            return;
+        }
+        $.ajax({
+            url: api + '?action=chunk&token=' + token + '&offset=' + offset
+            ,type: 'PUT'
+            ,data: file.slice(offset,offset + size)
+            ,dataType: 'json'
+            ,processData: false
+            ,contentType: 'application/octet-stream'
+            ,success: function(res){
+                if(res.code == 1){
+                    retry = 0;
+                    send(token,res.offset);
+                }
+                //偏移量不一致时从服务器返回的位置继续
+                else if(typeof(res.offset) != 'undefined'){
+                    send(token,res.offset);
+                }
+                else{
+                    start();
+                }
+            }
+            ,error: function(){
+                resume(token);
+            }
+        });
+    };
+    var token = store ? store.getItem(key) : null;
+    if(token){
+        resume(token);
+    }
+    else{
+        start();
+    }
+}
+
+//显示上传结果，多张图片时地址以空格分隔
+function upshow(results){
+    var urls = [];
+    var msg = '';
+    for(var i = 0;i < results.length;i++){
+        if(results[i].code == 1){
+            urls.push(results[i].url);
+            //请求接口处理图片
+            dispose(results[i].id,0);
+        }
+        else if(msg == ''){
+            msg = results[i].msg;
+        }
+    }
+    //全部上传失败
+    if(urls.length == 0){
+        layer.open({
+            title: '温馨提示'
+            ,content: msg
+        });
+        return;
+    }
+    var last = urls[urls.length - 1];
+    $("#showpic a").attr('href',last);
+    $("#showpic img").attr('src',last);
+    $("#url").val(urls.join(' '));
+    $("#html").val($.map(urls,function(url){ return "<img src = '" + url + "' />"; }).join(" "));
+    $("#markdown").val($.map(urls,function(url){ return "![](" + url + ")"; }).join(" "));
+    $("#bbcode").val($.map(urls,function(url){ return "[img]" + url + "[/img]"; }).join(" "));
+    $("#upok").show();
+    if(msg != ''){
+        layer.msg('部分图片上传失败：' + msg);
+    }
+}
+
+//请求接口处理图片，后台队列未处理完成时定时轮询鉴黄结果
+function dispose(id,times){
+    $.get("./dispose.php?id="+id,function(data,status){
+        var obj = eval('(' + data + ')');
+        if(obj.level == 3){
+            layer.open({
+                title: '温馨提示'
+                ,content: '请勿上传违规图片！'
+            }); 
+        }
+        else if((obj.status == 'pending') && (times < 10)){
+            setTimeout(function(){
+                dispose(id,times + 1);
+            },3000);
+        }
+    });
+}
+
 //复制链接
 function copy(info){
     var copy = new clipBoard(document.getElementById('piclink'), {
@@ -267,6 +452,107 @@ function cdubious(id){
     });
 }
 
+//全选/取消全选
+function checkall(obj){
+    $("input[name='picid']").prop("checked",obj.checked);
+}
+
+//批量操作选中的图片，type：delete/compress/cdubious
+function batch(type){
+    var ids = [];
+    $("input[name='picid']:checked").each(function(){
+        ids.push($(this).val());
+    });
+    if(ids.length == 0){
+        layer.msg('请选择图片！');
+        return;
+    }
+    var names = {delete:'删除',compress:'压缩',cdubious:'取消可疑状态'};
+    layer.confirm('确认' + names[type] + '选中的' + ids.length + '张图片？', {icon: 3, title:'温馨提示！'}, function(index){
+        layer.close(index);
+        layer.load();
+        $.post("./batch.php",{type:type,ids:ids.join(',')},function(data,status){
+            layer.closeAll('loading');
+            var obj = eval('(' + data + ')');
+            if(obj.code == 1){
+                //删除及取消可疑后从列表中移除
+                if(type != 'compress'){
+                    for(var i = 0;i < obj.ids.length;i++){
+                        $("#imgid" + obj.ids[i]).remove();
+                    }
+                }
+                $("#checkall").prop("checked",false);
+            }
+            layer.msg(obj.msg);
+        });
+    });
+}
+
+//转义HTML，用于拼接后台列表
+function escapehtml(str){
+    return String(str).replace(/&/g,'&amp;').replace(/</g,'&lt;').replace(/>/g,'&gt;').replace(/"/g,'&quot;').replace(/'/g,'&#39;');
+}
+
+//后台加载更多图片，type：user/admin/dubious/sm，view：table（表格）/preview（预览）
+function loadmore(type,view){
+    var cursor = $("#loadmore").attr("data-cursor");
+    $.get("./api.php?type=" + type + "&cursor=" + cursor,function(data,status){
+        var obj = eval('(' + data + ')');
+        if(obj.code != 1){
+            return;
+        }
+        var html = '';
+        for(var i = 0; i < obj.data.length; i++){
+            var img = obj.data[i];
+            var id = parseInt(img.id);
+            var url = escapehtml(img.url);
+            //SM.MS预览模式
+            if(view == 'preview'){
+                html += '<div class="layui-col-lg4 picadmin"><a id = "imgid' + id + '" href="javascript:;" onclick = "smshow(\'' + url + '\',' + id + ')"><img src="' + url + '"></a></div>';
+                continue;
+            }
+            html += '<tr id = "imgid' + id + '">';
+            //图片管理页面可多选
+            if(type != 'sm'){
+                html += '<td><input type="checkbox" name="picid" value="' + id + '" lay-ignore></td>';
+            }
+            html += '<td>' + id + '</td>';
+            if(type == 'sm'){
+                html += '<td><a href="javascript:;" onclick = "smshow(\'' + url + '\',' + id + ')">' + url + '</a></td>';
+            }
+            else{
+                html += '<td><a href="javascript:;" onclick = "adminshow(\'' + url + '\',' + id + ')">' + escapehtml(img.path) + '</a></td>';
+            }
+            html += '<td><a href="javascript:;" onclick = "ipquery(\'' + escapehtml(img.ip) + '\')">' + escapehtml(img.ip) + '</a></td>';
+            html += '<td>' + escapehtml(img.date) + '</td>';
+            if(type == 'sm'){
+                html += '<td><a href="javascript:;" class="layui-btn layui-btn-xs layui-btn-normal" onclick = "copyurl(\'' + url + '\')">复制</a> ';
+                html += '<a href="javascript:;" class="layui-btn layui-btn-xs layui-btn-danger" onclick = "deletesm(' + id + ')">删除</a></td></tr>';
+                continue;
+            }
+            if(img.compress == 0){
+                html += '<td><a href="javascript::" class = "layui-btn layui-btn-xs layui-btn-danger">否</a> ';
+            }
+            else{
+                html += '<td><a href="javascript::" class = "layui-btn layui-btn-xs layui-btn-normal">是</a> ';
+            }
+            html += '<a href="javascript:;" class = "layui-btn layui-btn-xs layui-btn-disabled">' + Math.round(img.size / 1024) + 'kb</a></td><td>';
+            if(type == 'dubious'){
+                html += '<a href="javascript:;" class="layui-btn layui-btn-xs layui-btn-normal" onclick = "cdubious(' + id + ')">非可疑</a> ';
+            }
+            else{
+                html += '<a href="javascript:;" class="layui-btn layui-btn-xs layui-btn-normal" onclick = "compress(' + id + ')">压缩</a> ';
+            }
+            html += '<a href="javascript:;" class="layui-btn layui-btn-xs layui-btn-danger" onclick = "deleteimg(' + id + ')">删除</a></td></tr>';
+        }
+        $("#piclist").append(html);
+        $("#loadmore").attr("data-cursor",obj.cursor);
+        if(!obj.more){
+            $("#loadmore").hide();
+        }
+    });
+}
+
 //图片压缩功能
 function compress(id){
     //layer.msg('该功能还在开发中！', {time: 2000})
@@ -0,0 +1,119 @@
+<?php
+    /*
+    缩略图接口：thumb.php?path=temp/1805/d64c8036c0605175.jpg&w=320&v=1525579200
+    缩略图按 原图路径 + 宽度 + 原图修改时间 生成缓存文件，TinyPNG压缩等改写原图后重新生成
+    v为原图修改时间，与当前一致时浏览器可长期缓存，否则每次通过ETag验证
+    */
+    error_reporting(E_ALL^E_NOTICE^E_WARNING^E_DEPRECATED);
+    //载入配置文件
+    include_once("./config.php");
+
+    //获取参数
+    $path = $_GET['path'];
+    $width = (int)$_GET['w'];
+
+    //只允许访问上传目录内的图片
+    $dir = explode('/',$path);
+    if(($path == '') || (strpos($path,'..') !== false) || (!in_array($dir[0],array($config['userdir'],$config['admindir'])))) {
+        header("HTTP/1.1 404 Not Found");
+        exit;
+    }
+    //使用对象存储且本地没有该文件时，跳转到对象存储的地址
+    if(!is_file(APP.$path)) {
+        if(($storage['driver'] != 'local') && ($storage['url'] != '')) {
+            header('Location: '.Storage::create($storage,$config['domain'])->url($path),true,302);
+            exit;
+        }
+        header("HTTP/1.1 404 Not Found");
+        exit;
+    }
+    $imgpath = APP.$path;
+    $info = getimagesize($imgpath);
+    if($info === false) {
+        header("HTTP/1.1 404 Not Found");
+        exit;
+    }
+
+    //宽度只能使用配置中的尺寸，取不小于请求宽度的最小值，避免任意尺寸占满缓存
+    $sizes = $thumb['width'];
+    sort($sizes);
+    $w = end($sizes);
+    foreach ($sizes as $value) {
+        if($value >= $width) {
+            $w = $value;
+            break;
+        }
+    }
+
+    //输出图片，支持If-None-Match返回304
+    function output($file,$mime,$etag) {
+        global $thumb,$imgpath;
+        //地址中没有版本或版本已过期时，原图可能被改写，不能长期缓存
+        if(isset($_GET['v']) && ((int)$_GET['v'] === filemtime($imgpath))) {
+            header('Cache-Control: public, max-age='.$thumb['maxage'].', immutable');
+        }
+        else{
+            header('Cache-Control: public, no-cache');
+        }
+        header('ETag: "'.$etag.'"');
+        header('Last-Modified: '.gmdate('D, d M Y H:i:s',filemtime($file)).' GMT');
+        if(isset($_SERVER['HTTP_IF_NONE_MATCH']) && (trim($_SERVER['HTTP_IF_NONE_MATCH']) == '"'.$etag.'"')) {
+            header("HTTP/1.1 304 Not Modified");
+            exit;
+        }
+        header('Content-Type: '.$mime);
+        header('Content-Length: '.filesize($file));
+        readfile($file);
+        exit;
+    }
+
+    //缓存标识：路径 + 宽度 + 原图修改时间（TinyPNG压缩后会重新生成） + 水印设置
+    $mark = new Watermark($watermark);
+    $sign = $mark->need($w) ? $mark->sign() : '';
+    $key = md5($path.'|'.$w.'|'.filemtime($imgpath).'|'.$sign);
+
+    //原图不超过缩略图宽度，或为GIF（缩放会丢失动画），直接输出原图
+    if(($info[0] <= $w) || ($info[2] == IMAGETYPE_GIF) || ($thumb['option'] != true)) {
+        output($imgpath,$info['mime'],$key);
+    }
+
+    //缓存路径：cache/thumb/ab/ab12...ef.jpg
+    $ext = strtolower(substr(strrchr($path, '.'), 1));
+    $cachedir = APP.$thumb['dir'].'/'.substr($key,0,2).'/';
+    $cachefile = $cachedir.$key.'.'.$ext;
+
+    if(!is_file($cachefile)) {
+        //使用上传类的缩放功能生成缩略图
+        $handle = new upload($imgpath);
+        //先写入临时文件名，生成完成后再更名，避免并发请求读到不完整的缩略图
+        $handle->file_new_name_body = $key.'_'.uniqid();
+        $handle->file_new_name_ext = $ext;
+        $handle->file_overwrite = true;
+        $handle->image_resize = true;
+        $handle->image_x = $w;
+        $handle->image_ratio_y = true;
+        $handle->image_no_enlarging = true;
+        $handle->jpeg_quality = $thumb['quality'];
+        //解码所需内存超过memory_limit剩余内存时不生成缩略图
+        $handle->image_max_memory = 'auto';
+        //叠加按宽度缓存的水印PNG
+        $start = $metrics->now();
+        $overlay = ($sign != '') ? $mark->overlay($w) : false;
+        $metrics->stop('image',$start,0,array("op" => "watermark"));
+        if($overlay !== false) {
+            $handle->image_watermark = $overlay;
+            $handle->image_watermark_position = $watermark['position'];
+            $handle->image_watermark_no_zoom_in = true;
+        }
+        $start = $metrics->now();
+        $handle->process($cachedir);
+        $metrics->stop('image',$start,filesize($imgpath),array("op" => "thumb"));
+        //生成失败时输出原图
+        if((!$handle->processed) || (!rename($handle->file_dst_pathname,$cachefile))) {
+            @unlink($handle->file_dst_pathname);
+            output($imgpath,$info['mime'],$key);
+        }
+    }
+
+    output($cachefile,$info['mime'],$key);
+?>
@@ -10,7 +10,7 @@
     <meta name="viewport" content="width=device-width, initial-scale=1.0">
     <link rel="shortcut icon" href="../favicon.ico"  type="image/x-icon" />
 	<link rel="Bookmark" href="../favicon.ico" />
-    <link rel="stylesheet" href="../static/layui/css/layui.css">
+    <link rel="stylesheet" href="../static/layui/css/layui.css?v=2.2.6">
     <link rel="stylesheet" href="../static/style.css?v=1.1">
     <script src = "https://libs.xiaoz.top/clipBoard.js/clipBoard.min.js"></script>
 </head>
@@ -17,7 +17,7 @@
 	</div>
 	<!-- 底部END -->
     <script src="https://cdn.bootcss.com/jquery/2.2.4/jquery.min.js"></script>
-	<script src="./static/layui/layui.js"></script>
-	<script src="./static/embed.js?v=1.1"></script>
+	<script src="./static/layui/layui.js?v=2.2.6"></script>
+	<script src="./static/embed.js?v=1.2.5"></script>
 </body>
 </html>
\ No newline at end of file
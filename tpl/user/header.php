@@ -11,7 +11,7 @@
     <meta name="viewport" content="width=device-width, initial-scale=1.0">
     <link rel="shortcut icon" href="favicon.ico"  type="image/x-icon" />
 	<link rel="Bookmark" href="favicon.ico" />
-    <link rel="stylesheet" href="./static/layui/css/layui.css">
+    <link rel="stylesheet" href="./static/layui/css/layui.css?v=2.2.6">
     <link rel="stylesheet" href="./static/style.css?v=1.10506">
     <script src = "https://libs.xiaoz.top/clipBoard.js/clipBoard.min.js"></script>
 </head>
@@ -43,7 +43,7 @@
                             if(isset($_COOKIE['user'])) {
                         ?>
                         <li class="layui-nav-item">
-                            <a href=""><img src="./static/none.jpg" class="layui-nav-img"><?php echo $_COOKIE['user']; ?></a>
+                            <a href=""><img src="./static/none.jpg" class="layui-nav-img"><?php echo htmlspecialchars($_COOKIE['user']); ?></a>
                             <dl class="layui-nav-child">
                                 <dd><a href="./admin/index.php">后台管理</a></dd>
                                 <dd><a href="./admin/logout.php">退出</a></dd>
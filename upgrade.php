@@ -10,6 +10,27 @@
 		exit;
 	}
 
+	//判断字段是否已经存在，保证升级脚本可以重复执行
+	function hascolumn($database,$table,$column) {
+		$columns = $database->query('PRAGMA table_info("'.$table.'")')->fetchAll();
+		foreach ($columns as $value) {
+			if($value['name'] == $column) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//依次执行升级SQL，任何一条失败即停止
+	function runsqls($database,$sqls) {
+		$schema = new Schema($database);
+		if(!$schema->run($sqls)) {
+			echo '升级失败，请检查数据库是否可写及是否有足够的权限！<br />'.nl2br(htmlspecialchars($schema->error));
+			exit;
+		}
+		echo '升级成功！';
+	}
+
 	//判断版本号
 	switch ( $v )
 	{
@@ -31,7 +52,142 @@ CONSTRAINT "delete" UNIQUE ("delete")
 			else{
 				echo '数据表创建失败，可能是数据库不可写或已经升级过！';
 			}
-			break;		
+			break;
+		case "1.2":
+			//MySQL/PostgreSQL按对应的语法建立表、补充字段、索引及统计触发器
+			if($database->type() != 'sqlite') {
+				$schema = new Schema($database);
+				runsqls($database,array_merge($schema->sqls(),$schema->rebuild(),array($schema->analyze())));
+				break;
+			}
+			//需要执行的SQL，均可重复执行
+			$sqls = array();
+			//图片hash字段，上传前据此去重
+			if(!hascolumn($database,'imginfo','hash')) {
+				$sqls[] = 'ALTER TABLE "main"."imginfo" ADD COLUMN "hash" TEXT';
+			}
+			$sqls[] = 'CREATE INDEX IF NOT EXISTS "imginfo_hash" ON "imginfo" ("hash")';
+			//整数日期字段(20180506)，按月/按天统计走范围查询，不再使用LIKE
+			if(!hascolumn($database,'imginfo','day')) {
+				$sqls[] = 'ALTER TABLE "main"."imginfo" ADD COLUMN "day" INTEGER';
+			}
+			$sqls[] = 'UPDATE "imginfo" SET "day" = CAST(REPLACE("date",\'-\',\'\') AS INTEGER) WHERE "day" IS NULL';
+			//同一路径有多条记录时无法建立唯一索引，列出重复的路径及ID，由管理员确认后手动删除，不自动删除用户数据
+			$duplicates = $database->query('SELECT "path",GROUP_CONCAT("id") AS "ids" FROM "imginfo" GROUP BY "path" HAVING COUNT(*) > 1')->fetchAll();
+			if(!empty($duplicates)) {
+				echo '升级已停止：以下路径存在重复的记录，请保留其中一条并删除其余记录后重新升级。<br />';
+				foreach ($duplicates as $duplicate) {
+					echo htmlspecialchars($duplicate['path']).'（ID：'.$duplicate['ids'].'）<br />';
+				}
+				exit;
+			}
+			$sqls[] = 'CREATE UNIQUE INDEX IF NOT EXISTS "imginfo_path" ON "imginfo" ("path")';
+			//游客上传限制：ip + day + dir
+			$sqls[] = 'CREATE INDEX IF NOT EXISTS "imginfo_limit" ON "imginfo" ("ip","day","dir")';
+			//后台按目录、按等级分页：dir/level + id DESC
+			$sqls[] = 'CREATE INDEX IF NOT EXISTS "imginfo_dir" ON "imginfo" ("dir","id")';
+			$sqls[] = 'CREATE INDEX IF NOT EXISTS "imginfo_level" ON "imginfo" ("level","id")';
+			//后台统计本月、今日上传数量
+			$sqls[] = 'CREATE INDEX IF NOT EXISTS "imginfo_day" ON "imginfo" ("day")';
+			//探索发现：dir + day范围 + level，带上path作为覆盖索引
+			$sqls[] = 'CREATE INDEX IF NOT EXISTS "imginfo_found" ON "imginfo" ("dir","day","level","path")';
+			//TinyPNG压缩节省的字节数
+			if(!hascolumn($database,'imginfo','saved')) {
+				$sqls[] = 'ALTER TABLE "main"."imginfo" ADD COLUMN "saved" INTEGER';
+			}
+			//图片大小、尺寸、MIME及压缩后大小，旧数据请执行 php functions/backfill.php 回填
+			$columns = array(
+				"size"      =>  "INTEGER",
+				"csize"     =>  "INTEGER",
+				"width"     =>  "INTEGER",
+				"height"    =>  "INTEGER",
+				"mime"      =>  "TEXT"
+			);
+			foreach ($columns as $column => $type) {
+				if(!hascolumn($database,'imginfo',$column)) {
+					$sqls[] = 'ALTER TABLE "main"."imginfo" ADD COLUMN "'.$column.'" '.$type;
+				}
+			}
+			//TinyPNG key每月使用次数
+			$sqls[] = 'CREATE TABLE IF NOT EXISTS "tinykey" (
+"key" TEXT PRIMARY KEY NOT NULL,
+"month" INTEGER NOT NULL,
+"count" INTEGER NOT NULL DEFAULT 0
+)';
+			//后台任务队列
+			$sqls[] = 'CREATE TABLE IF NOT EXISTS "queue" (
+"id" INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL,
+"type" TEXT NOT NULL,
+"target" INTEGER NOT NULL,
+"data" TEXT,
+"status" INTEGER NOT NULL DEFAULT 0,
+"attempts" INTEGER NOT NULL DEFAULT 0,
+"runat" INTEGER NOT NULL,
+"lease" INTEGER NOT NULL DEFAULT 0,
+"owner" TEXT,
+"error" TEXT,
+"created" INTEGER NOT NULL,
+CONSTRAINT "job" UNIQUE ("type","target")
+)';
+			$sqls[] = 'CREATE INDEX IF NOT EXISTS "queue_claim" ON "queue" ("status","runat")';
+			$sqls[] = 'CREATE INDEX IF NOT EXISTS "queue_owner" ON "queue" ("owner")';
+			//游客上传频率限制
+			$sqls[] = 'CREATE TABLE IF NOT EXISTS "limiter" (
+"key" TEXT PRIMARY KEY NOT NULL,
+"tokens" REAL NOT NULL,
+"updated" INTEGER NOT NULL
+)';
+			//统计表，按 天 + 目录 + 等级 记录图片数量及大小，由触发器随imginfo同步更新
+			$sqls[] = 'CREATE TABLE IF NOT EXISTS "stats" (
+"day" INTEGER NOT NULL,
+"dir" TEXT NOT NULL,
+"level" INTEGER NOT NULL,
+"num" INTEGER NOT NULL DEFAULT 0,
+"bytes" INTEGER NOT NULL DEFAULT 0,
+PRIMARY KEY ("day","dir","level")
+)';
+			$sqls[] = 'CREATE TRIGGER IF NOT EXISTS "stats_insert" AFTER INSERT ON "imginfo" BEGIN
+INSERT OR IGNORE INTO "stats" ("day","dir","level") VALUES (IFNULL(NEW."day",0),NEW."dir",IFNULL(NEW."level",0));
+UPDATE "stats" SET "num" = "num" + 1, "bytes" = "bytes" + IFNULL(NEW."csize",0) WHERE "day" = IFNULL(NEW."day",0) AND "dir" = NEW."dir" AND "level" = IFNULL(NEW."level",0);
+END';
+			$sqls[] = 'CREATE TRIGGER IF NOT EXISTS "stats_delete" AFTER DELETE ON "imginfo" BEGIN
+UPDATE "stats" SET "num" = "num" - 1, "bytes" = "bytes" - IFNULL(OLD."csize",0) WHERE "day" = IFNULL(OLD."day",0) AND "dir" = OLD."dir" AND "level" = IFNULL(OLD."level",0);
+END';
+			$sqls[] = 'CREATE TRIGGER IF NOT EXISTS "stats_update" AFTER UPDATE OF "day","dir","level","csize" ON "imginfo" BEGIN
+UPDATE "stats" SET "num" = "num" - 1, "bytes" = "bytes" - IFNULL(OLD."csize",0) WHERE "day" = IFNULL(OLD."day",0) AND "dir" = OLD."dir" AND "level" = IFNULL(OLD."level",0);
+INSERT OR IGNORE INTO "stats" ("day","dir","level") VALUES (IFNULL(NEW."day",0),NEW."dir",IFNULL(NEW."level",0));
+UPDATE "stats" SET "num" = "num" + 1, "bytes" = "bytes" + IFNULL(NEW."csize",0) WHERE "day" = IFNULL(NEW."day",0) AND "dir" = NEW."dir" AND "level" = IFNULL(NEW."level",0);
+END';
+			//感知hash及其4段，鉴黄时按段查询相似图片
+			$columns = array("phash" => "TEXT","ph1" => "INTEGER","ph2" => "INTEGER","ph3" => "INTEGER","ph4" => "INTEGER");
+			foreach ($columns as $column => $type) {
+				if(!hascolumn($database,'imginfo',$column)) {
+					$sqls[] = 'ALTER TABLE "main"."imginfo" ADD COLUMN "'.$column.'" '.$type;
+				}
+			}
+			for($i = 1;$i <= 4;$i++) {
+				$sqls[] = 'CREATE INDEX IF NOT EXISTS "imginfo_ph'.$i.'" ON "imginfo" ("ph'.$i.'")';
+			}
+			//SM.MS镜像对应的本站图片ID，由后台任务镜像的图片才有
+			if(!hascolumn($database,'sm','imgid')) {
+				$sqls[] = 'ALTER TABLE "main"."sm" ADD COLUMN "imgid" INTEGER';
+			}
+			$sqls[] = 'CREATE INDEX IF NOT EXISTS "sm_imgid" ON "sm" ("imgid")';
+			//拍摄设备、拍摄时间及GPS坐标，开启$exif['save']后上传时写入
+			$columns = array("make" => "TEXT","model" => "TEXT","taken" => "TEXT","lat" => "REAL","lng" => "REAL");
+			foreach ($columns as $column => $type) {
+				if(!hascolumn($database,'imginfo',$column)) {
+					$sqls[] = 'ALTER TABLE "main"."imginfo" ADD COLUMN "'.$column.'" '.$type;
+				}
+			}
+			//根据现有数据重新生成统计
+			$sqls[] = 'DELETE FROM "stats"';
+			$sqls[] = 'INSERT INTO "stats" ("day","dir","level","num","bytes") SELECT IFNULL("day",0),"dir",IFNULL("level",0),COUNT(*),SUM(IFNULL("csize",0)) FROM "imginfo" GROUP BY IFNULL("day",0),"dir",IFNULL("level",0)';
+			//更新查询计划统计信息
+			$sqls[] = 'ANALYZE';
+
+			runsqls($database,$sqls);
+			break;
 		default:
 			echo '未知的版本号！';
 			exit;